@@ -28,6 +28,13 @@
     #define SCAR_RELEASE
 #endif
 
+#if defined(__AVX2__)
+    #define SCAR_SIMD_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SCAR_SIMD_SSE2
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 // VARIABLES
@@ -0,0 +1,102 @@
+#include "scarpch.hpp"
+#include "Core/Diagnostic.hpp"
+
+#include <sstream>
+
+namespace scar {
+
+    struct DiagInfo {
+        Severity Level;
+        const char* Message;
+    };
+
+    static constexpr DiagInfo s_DiagInfos[] = {
+#define SCAR_DIAG_INFO(name, severity, message) { Severity::severity, message },
+        SCAR_DIAGNOSTICS(SCAR_DIAG_INFO)
+#undef SCAR_DIAG_INFO
+    };
+
+    Severity GetSeverity(DiagID id) {
+        return s_DiagInfos[(size_t)id].Level;
+    }
+
+    std::string DiagArg::ToString() const {
+        if (!m_Print) {
+            return m_String;
+        }
+        std::ostringstream stream;
+        m_Print(stream, m_Storage);
+        return stream.str();
+    }
+
+    static std::string FormatMessage(const Diagnostic& diagnostic) {
+        std::string_view message = s_DiagInfos[(size_t)diagnostic.ID].Message;
+
+        std::array<std::string, DiagnosticEngine::MaxArgs> args;
+        for (size_t i = 0; i < diagnostic.Args.size(); i++) {
+            args[i] = diagnostic.Args[i].ToString();
+        }
+
+        switch (diagnostic.Args.size()) {
+        case 0:  return std::string(message);
+        case 1:  return fmt::vformat(message, fmt::make_format_args(args[0]));
+        case 2:  return fmt::vformat(message, fmt::make_format_args(args[0], args[1]));
+        default: return fmt::vformat(message, fmt::make_format_args(args[0], args[1], args[2]));
+        }
+    }
+
+    void DiagnosticEngine::Add(Diagnostic&& diagnostic) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_ReachedErrorLimit) {
+            return;
+        }
+
+        Severity severity = GetSeverity(diagnostic.ID);
+        if (severity >= Severity::Error) {
+            if (m_ErrorLimit != 0 && m_ErrorCount >= m_ErrorLimit) {
+                m_ReachedErrorLimit = true;
+                m_Diagnostics.push_back(Diagnostic{ DiagID::TooManyErrors });
+                return;
+            }
+            m_ErrorCount++;
+        }
+
+        m_Diagnostics.push_back(std::move(diagnostic));
+        if (severity == Severity::Fatal) {
+            m_ReachedErrorLimit = true;
+        }
+    }
+
+    void DiagnosticEngine::Append(DiagnosticEngine& other) {
+        for (Diagnostic& diagnostic : other.m_Diagnostics) {
+            Add(std::move(diagnostic));
+        }
+        other.m_Diagnostics.clear();
+    }
+
+    void DiagnosticEngine::SortBySpan() {
+        std::stable_sort(m_Diagnostics.begin(), m_Diagnostics.end(), [](const Diagnostic& lhs, const Diagnostic& rhs) {
+            if (!lhs.Span || !rhs.Span) {
+                return lhs.Span && !rhs.Span;
+            }
+            return std::make_pair(lhs.Span->File, lhs.Span->Index) < std::make_pair(rhs.Span->File, rhs.Span->Index);
+        });
+    }
+
+    void DiagnosticEngine::Flush() {
+        for (const Diagnostic& diagnostic : m_Diagnostics) {
+            std::string message = FormatMessage(diagnostic);
+            if (diagnostic.Span) {
+                message = FMT("{}: {}", *diagnostic.Span, message);
+            }
+
+            switch (GetSeverity(diagnostic.ID)) {
+            case Severity::Note:    Session::Info(message); break;
+            case Severity::Warning: Session::Warn(message); break;
+            default:                Session::Error(message); break;
+            }
+        }
+        m_Diagnostics.clear();
+    }
+
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include "Parse/Span.hpp"
+
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+
+// Every diagnostic the compiler can report: its ID, severity and message.
+// Each {} in the message is replaced by one of the diagnostic's arguments.
+#define SCAR_DIAGNOSTICS(X) \
+    /* Internal */ \
+    X(Internal,              Error,   "{}") \
+    X(TooManyErrors,         Fatal,   "too many errors emitted, stopping now") \
+    /* Command line */ \
+    X(UnknownOption,         Error,   "unknown option: {}") \
+    X(InvalidThreadCount,    Error,   "invalid thread count: {}") \
+    X(InvalidErrorLimit,     Error,   "invalid error limit: {}") \
+    X(InvalidOptLevel,       Error,   "invalid optimization level: {}") \
+    X(MultipleInputFiles,    Error,   "multiple input files specified!") \
+    X(NoInputFile,           Error,   "no input file specified!") \
+    /* Source files */ \
+    X(FileOpenFailed,        Error,   "failed to open file: {}") \
+    X(FileTooLarge,          Error,   "file too large: {}") \
+    X(InvalidUTF8,           Error,   "invalid UTF-8") \
+    /* Lexer */ \
+    X(UnrecognizedSymbol,    Error,   "unrecognized symbol '{}'") \
+    X(UnterminatedComment,   Error,   "unexpected end of file in comment") \
+    X(MissingBinaryValue,    Error,   "binary number missing value") \
+    X(MissingOctalValue,     Error,   "octal number missing value") \
+    X(MissingHexValue,       Error,   "hexadecimal number missing value") \
+    X(NonDecimalFraction,    Error,   "only decimal numbers support fractions and exponents") \
+    X(MissingExponent,       Error,   "exponent requires a value") \
+    X(InvalidNumericEscape,  Error,   "invalid numeric escape : '{}'") \
+    /* Parser */ \
+    X(UnexpectedToken,       Error,   "unexpected token: {} where {} was expected") \
+    X(ExpectedDeclaration,   Error,   "expected a declaration") \
+    X(ExpectedStatement,     Error,   "expected a statement") \
+    X(InvalidExpression,     Error,   "invalid expression") \
+    /* Verification */ \
+    X(VoidVariable,          Error,   "invalid void type variable") \
+    X(ExpectedCondition,     Error,   "expectead a boolean, found {}") \
+    X(ReturnTypeMismatch,    Error,   "return value does not match function type") \
+    X(UndeclaredVariable,    Error,   "undeclared variable: {}") \
+    X(InvalidExpressionType, Error,   "invalid expression type") \
+    X(ExpectedNumber,        Error,   "expected an integer or float, found {}") \
+    X(ExpectedBool,          Error,   "expected a bool, found {}") \
+    X(ExpectedInteger,       Error,   "expected an integer, found {}") \
+    X(TypeMismatch,          Error,   "type mismatch: {} and {}") \
+    X(AssignToNonVariable,   Error,   "binary operator {} requires a variable") \
+    /* Code generation */ \
+    X(UndeclaredFunction,    Error,   "undeclared funcation call: {}") \
+    X(ArgumentCountMismatch, Error,   "incorrect number of arguments: {}") \
+    X(CodegenLinkFailed,     Error,   "failed to link generated code: {}") \
+    X(InvalidCast,           Error,   "invalid cast")
+
+namespace scar {
+
+    enum class DiagID : uint16_t {
+#define SCAR_DIAG_ENUM(name, severity, message) name,
+        SCAR_DIAGNOSTICS(SCAR_DIAG_ENUM)
+#undef SCAR_DIAG_ENUM
+    };
+
+    enum class Severity : uint8_t {
+        Note,
+        Warning,
+        Error,
+        // Like Error, but nothing gets reported after it
+        Fatal,
+    };
+
+    Severity GetSeverity(DiagID id);
+
+    // Argument of a Diagnostic, it's only turned into text when the Diagnostic is emitted.
+    // Small trivially copyable values are stored as they are, anything else has to be a string.
+    class DiagArg {
+    public:
+        template<typename T, typename = std::enable_if_t<std::is_trivially_copyable_v<T> && !std::is_pointer_v<T> && !std::is_array_v<T>>>
+        DiagArg(const T& value) :
+            m_Print(&Print<T>)
+        {
+            static_assert(sizeof(T) <= StorageSize && alignof(T) <= alignof(uint64_t), "diagnostic argument is too large, pass it as a string");
+            std::memcpy(m_Storage, &value, sizeof(T));
+        }
+        DiagArg(std::string value) : m_String(std::move(value)) {}
+        DiagArg(const char* value) : m_String(value) {}
+
+        std::string ToString() const;
+
+    private:
+        static constexpr size_t StorageSize = 32;
+
+        alignas(uint64_t) char m_Storage[StorageSize];
+        void (*m_Print)(std::ostream&, const void*) = nullptr;
+        std::string m_String;
+
+        template<typename T>
+        static void Print(std::ostream& os, const void* value) {
+            os << *(const T*)value;
+        }
+    };
+
+    struct Diagnostic {
+        DiagID ID;
+        std::optional<TextSpan> Span;
+        std::vector<DiagArg> Args;
+    };
+
+    // Collects Diagnostics and emits them in the order they were reported.
+    // Reporting is locked since SCAR_ERROR reports to the Session's engine from any thread. Threads should
+    // still report into their own engine and get appended afterwards, nothing else is thread-safe.
+    class DiagnosticEngine {
+    public:
+        static constexpr size_t MaxArgs = 3;
+
+        // Zero means there is no error limit
+        explicit DiagnosticEngine(uint32_t errorLimit = 0) : m_ErrorLimit(errorLimit) {}
+
+        template<typename... Args>
+        void Report(DiagID id, Args&&... args) {
+            static_assert(sizeof...(Args) <= MaxArgs, "too many diagnostic arguments");
+            Add(Diagnostic{ id, std::nullopt, { DiagArg(std::forward<Args>(args))... } });
+        }
+        template<typename... Args>
+        void Report(const TextSpan& span, DiagID id, Args&&... args) {
+            static_assert(sizeof...(Args) <= MaxArgs, "too many diagnostic arguments");
+            Add(Diagnostic{ id, span, { DiagArg(std::forward<Args>(args))... } });
+        }
+
+        // Move every Diagnostic of other to the end of this engine
+        void Append(DiagnosticEngine& other);
+        // Order the buffered Diagnostics by their position in the source, the ones without a span go last
+        void SortBySpan();
+        // Format and log every buffered Diagnostic
+        void Flush();
+
+        uint32_t GetErrorCount() const { return m_ErrorCount; }
+        bool HasErrors() const { return m_ErrorCount > 0; }
+        // Once the limit is reached or a Fatal Diagnostic is reported, every further Diagnostic is dropped
+        bool HasReachedErrorLimit() const { return m_ReachedErrorLimit; }
+        void SetErrorLimit(uint32_t errorLimit) { m_ErrorLimit = errorLimit; }
+
+    private:
+        std::vector<Diagnostic> m_Diagnostics;
+        uint32_t m_ErrorCount = 0;
+        uint32_t m_ErrorLimit = 0;
+        bool m_ReachedErrorLimit = false;
+        std::mutex m_Mutex;
+
+        void Add(Diagnostic&& diagnostic);
+    };
+
+}
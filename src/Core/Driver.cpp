@@ -3,8 +3,10 @@
 #include "Core/Session.hpp"
 #include "Parse/Parser.hpp"
 #include "Parse/AST/LLVMVisitor.hpp"
+#include "Parse/AST/ResolveVisitor.hpp"
 #include "Parse/AST/VerifyVisitor.hpp"
 #include "Parse/AST/PrintVisitor.hpp"
+#include "Parse/AST/FlatAST.hpp"
 
 namespace scar {
 
@@ -13,36 +15,81 @@ namespace scar {
         scar::Session::Init(args);
     }
 
-    void Driver::Compile() {
-        if (!Session::IsGood())
-            return;
+    // Each pass only runs if the ones before it succeeded,
+    // their diagnostics are emitted as soon as they're done
+    static void RunPasses(ast::Module* ast) {
+        DiagnosticEngine& diagnostics = Session::GetDiagnostics();
 
-        try {
-            Parser parser(Session::GetInputFile());
-            auto ast = parser.Parse();
+        // Parses the skipped function bodies that are called, their syntax errors stop the later passes
+        if (Session::IsGood()) {
+            ast::ResolveVisitor resolve;
+            ast->Accept(resolve);
+            diagnostics.SortBySpan();
+            diagnostics.Flush();
+        }
 
-            if (Session::IsGood()) {
-                ast::VerifyVisitor verify;
-                ast->Accept(verify);
-            }
+        if (Session::IsGood()) {
+            ast::VerifyVisitor verify(diagnostics);
+            ast->Accept(verify);
+            diagnostics.Flush();
+        }
 
-            if (Session::IsGood()) {
+        if (Session::IsGood()) {
+            if (Session::GetProperties().FlatAST) {
+                ast::FlatAST::FromTree(*ast).Print();
+            }
+            else {
                 ast::PrintVisitor print;
                 ast->Accept(print);
             }
+        }
 
+        if (Session::IsGood()) {
+            ast::LLVMVisitor codegen(diagnostics);
+            ast->Accept(codegen);
+            diagnostics.Flush();
             if (Session::IsGood()) {
-                ast::LLVMVisitor codegen;
-                ast->Accept(codegen);
                 codegen.Print();
             }
         }
-        catch (CompilerError& e) {
-            e.OnCatch();
+    }
+
+    void Driver::Compile() {
+        if (!Session::IsGood())
+            return;
+
+        // Failing to load the input is reported by the SourceMap
+        if (!SourceMap::Load(Session::GetInputFile()))
+            return;
+
+        // Owns the AST until the end of compilation
+        ast::ASTContext context;
+        Parser parser(Session::GetInputFile(), context);
+        auto ast = parser.Parse();
+
+        // Skipped bodies are parsed once a call reaches them, but the passes don't run after an error.
+        // Parse them all now so their syntax errors are reported as well.
+        if (!Session::IsGood() && parser.GetUnparsedBodyCount() && !Session::GetDiagnostics().HasReachedErrorLimit()) {
+            for (auto& item : ast->Items) {
+                if (auto function = dynamic_cast<ast::Function*>(item)) {
+                    function->GetCodeBlock();
+                }
+            }
+        }
+        // Bodies are parsed after the rest of the file, report in source order like an eager parse
+        Session::GetDiagnostics().SortBySpan();
+        Session::GetDiagnostics().Flush();
+
+        RunPasses(ast);
+
+        if (uint32_t count = parser.GetUnparsedBodyCount()) {
+            SCAR_INFO("{} function bod{} never parsed", count, count > 1 ? "ies were" : "y was");
         }
     }
 
     void Driver::Exit() {
+        Session::GetDiagnostics().Flush();
+
         if (Session::IsGood()) {
             SCAR_INFO("Compilation successful");
         }
@@ -1,6 +1,5 @@
 #pragma once
 #include "Core/Session.hpp"
-#include "Core/Error.hpp"
 
 #include <fmt/core.h>
 #include <fmt/format.h>
@@ -26,5 +25,6 @@ namespace scar {
 #define SCAR_TRACE(...) ::scar::Session::Trace(FMT(__VA_ARGS__))
 #define SCAR_INFO(...)  ::scar::Session::Info(FMT(__VA_ARGS__))
 #define SCAR_WARN(...)  ::scar::Session::Warn(FMT(__VA_ARGS__))
-#define SCAR_ERROR(...) throw ::scar::CompilerError(FMT(__VA_ARGS__));
-#define SCAR_CRITICAL(...) { SCAR_ERROR(__VA_ARGS__); throw std::runtime_error(FMT(__VA_ARGS__)); }
+#define SCAR_ERROR(...) ::scar::Session::GetDiagnostics().Report(::scar::DiagID::Internal, FMT(__VA_ARGS__))
+// Unrecoverable, emitted right away since it may come from any thread
+#define SCAR_CRITICAL(...) { ::scar::Session::Error(FMT(__VA_ARGS__)); std::abort(); }
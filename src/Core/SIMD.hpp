@@ -0,0 +1,86 @@
+#pragma once
+
+#if defined(SCAR_SIMD_SSE2) || defined(SCAR_SIMD_AVX2)
+    #include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace scar {
+    namespace simd {
+
+        // Index of the lowest set bit; mask must not be zero
+        inline unsigned int CountTrailingZeros(uint32_t mask) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return (unsigned int)index;
+#else
+            return (unsigned int)__builtin_ctz(mask);
+#endif
+        }
+
+        // Get the offset of the first byte in [begin, end) that isn't ASCII,
+        // or the length of the range if all of it is
+        inline size_t FindNonASCII(const char* begin, const char* end) {
+            const char* ptr = begin;
+#if defined(SCAR_SIMD_AVX2)
+            for (; end - ptr >= 32; ptr += 32) {
+                __m256i chunk = _mm256_loadu_si256((const __m256i*)ptr);
+                uint32_t mask = (uint32_t)_mm256_movemask_epi8(chunk);
+                if (mask != 0) {
+                    return (size_t)(ptr - begin) + CountTrailingZeros(mask);
+                }
+            }
+#endif
+#if defined(SCAR_SIMD_SSE2)
+            for (; end - ptr >= 16; ptr += 16) {
+                __m128i chunk = _mm_loadu_si128((const __m128i*)ptr);
+                uint32_t mask = (uint32_t)_mm_movemask_epi8(chunk);
+                if (mask != 0) {
+                    return (size_t)(ptr - begin) + CountTrailingZeros(mask);
+                }
+            }
+#endif
+            for (; ptr < end; ptr++) {
+                if ((uint8_t)*ptr >= 0x80) {
+                    break;
+                }
+            }
+            return (size_t)(ptr - begin);
+        }
+
+        // Call func with the offset of every byte in [begin, end) equal to c
+        template<typename Func>
+        void ForEachByte(const char* begin, const char* end, char c, Func&& func) {
+            const char* ptr = begin;
+#if defined(SCAR_SIMD_AVX2)
+            const __m256i needle32 = _mm256_set1_epi8(c);
+            for (; end - ptr >= 32; ptr += 32) {
+                __m256i chunk = _mm256_loadu_si256((const __m256i*)ptr);
+                uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle32));
+                for (; mask != 0; mask &= mask - 1) {
+                    func((size_t)(ptr - begin) + CountTrailingZeros(mask));
+                }
+            }
+#endif
+#if defined(SCAR_SIMD_SSE2)
+            const __m128i needle16 = _mm_set1_epi8(c);
+            for (; end - ptr >= 16; ptr += 16) {
+                __m128i chunk = _mm_loadu_si128((const __m128i*)ptr);
+                uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle16));
+                for (; mask != 0; mask &= mask - 1) {
+                    func((size_t)(ptr - begin) + CountTrailingZeros(mask));
+                }
+            }
+#endif
+            for (; ptr < end; ptr++) {
+                if (*ptr == c) {
+                    func((size_t)(ptr - begin));
+                }
+            }
+        }
+
+    }
+}
@@ -1,14 +1,132 @@
 #include "scarpch.hpp"
 #include "Core/Session.hpp"
+#include "Core/ThreadPool.hpp"
 
 namespace scar {
 
+    // Parse a decimal number, digits are only accepted while the value is at most max
+    static bool ParseCount(std::string_view digits, uint32_t max, uint32_t& value) {
+        value = 0;
+        for (char c : digits) {
+            if (c < '0' || c > '9' || value > max) {
+                return false;
+            }
+            value = value * 10 + (uint32_t)(c - '0');
+        }
+        return !digits.empty();
+    }
+
+    // Returns false if the flag is invalid
+    static bool ParseFlag(SessionProperties& properties, std::string_view flag) {
+        if (flag == "-fstream-tokens") {
+            properties.StreamTokens = true;
+        }
+        else if (flag == "-fno-stream-tokens") {
+            properties.StreamTokens = false;
+        }
+        else if (flag == "-fparallel-lex") {
+            properties.ParallelLex = true;
+        }
+        else if (flag == "-fno-parallel-lex") {
+            properties.ParallelLex = false;
+        }
+        else if (flag == "-fparallel-parse") {
+            properties.ParallelParse = true;
+        }
+        else if (flag == "-fno-parallel-parse") {
+            properties.ParallelParse = false;
+        }
+        else if (flag == "-fparallel-verify") {
+            properties.ParallelVerify = true;
+        }
+        else if (flag == "-fno-parallel-verify") {
+            properties.ParallelVerify = false;
+        }
+        else if (flag == "-fparallel-codegen") {
+            properties.ParallelCodegen = true;
+        }
+        else if (flag == "-fno-parallel-codegen") {
+            properties.ParallelCodegen = false;
+        }
+        else if (flag == "-feager-parse") {
+            properties.EagerParse = true;
+        }
+        else if (flag == "-fno-eager-parse") {
+            properties.EagerParse = false;
+        }
+        else if (flag == "-fflat-ast") {
+            properties.FlatAST = true;
+        }
+        else if (flag == "-fno-flat-ast") {
+            properties.FlatAST = false;
+        }
+        else if (flag.substr(0, 14) == "-ferror-limit=") {
+            if (!ParseCount(flag.substr(14), 100000000, properties.ErrorLimit)) {
+                Session::GetDiagnostics().Report(DiagID::InvalidErrorLimit, flag);
+                return false;
+            }
+        }
+        else if (flag.substr(0, 2) == "-O") {
+            if (!ParseCount(flag.substr(2), 3, properties.OptLevel) || properties.OptLevel > 3) {
+                Session::GetDiagnostics().Report(DiagID::InvalidOptLevel, flag);
+                return false;
+            }
+        }
+        else if (flag.substr(0, 2) == "-j") {
+            if (!ParseCount(flag.substr(2), 1024, properties.ThreadCount) || properties.ThreadCount == 0) {
+                Session::GetDiagnostics().Report(DiagID::InvalidThreadCount, flag);
+                return false;
+            }
+        }
+        else {
+            Session::GetDiagnostics().Report(DiagID::UnknownOption, flag);
+            return false;
+        }
+        return true;
+    }
+
     void Session::Init(const std::vector<const char*>& args) {
-        if (args.size() == 1) {
-            SCAR_ERROR("no input file specified!");
+        SessionProperties& properties = GetProperties();
+        properties.Args = args;
+
+        // Stop at the first invalid argument
+        for (size_t i = 1; i < args.size(); i++) {
+            std::string_view arg = args[i];
+            // A lone "-" is stdin
+            if (arg.size() > 1 && arg[0] == '-') {
+                if (!ParseFlag(properties, arg)) {
+                    return;
+                }
+            }
+            else if (!properties.InputFile) {
+                properties.InputFile = args[i];
+            }
+            else {
+                GetDiagnostics().Report(DiagID::MultipleInputFiles);
+                return;
+            }
+        }
+
+        if (!properties.InputFile) {
+            GetDiagnostics().Report(DiagID::NoInputFile);
             return;
         }
-        GetProperties().InputFile = args[1];
+
+        GetDiagnostics().SetErrorLimit(properties.ErrorLimit);
+    }
+
+    uint32_t Session::GetErrorCount() {
+        return GetDiagnostics().GetErrorCount();
+    }
+
+    ThreadPool& Session::GetThreadPool() {
+        static ThreadPool pool(GetProperties().ThreadCount);
+        return pool;
+    }
+
+    DiagnosticEngine& Session::GetDiagnostics() {
+        static DiagnosticEngine diagnostics;
+        return diagnostics;
     }
 
     void Session::Trace(const std::string& message) {
@@ -22,7 +140,6 @@ namespace scar {
     }
     void Session::Error(const std::string& message) {
         Log::GetLogger()->error(message);
-        GetProperties().ErrorCount++;
     }
 
 }
\ No newline at end of file
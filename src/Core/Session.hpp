@@ -2,19 +2,46 @@
 
 namespace scar {
 
+    class DiagnosticEngine;
+    class ThreadPool;
+
     struct SessionProperties {
-        uint32_t ErrorCount = 0;
-        const char* InputFile;
+        const char* InputFile = nullptr;
         std::vector<const char*> Args;
+
+        // -f[no-]stream-tokens: parse while lexing instead of lexing the whole file up front
+        bool StreamTokens = true;
+        // -f[no-]parallel-lex: lex large files in chunks on the thread pool
+        bool ParallelLex = false;
+        // -f[no-]parallel-parse: parse functions on the thread pool, implies -fno-stream-tokens
+        bool ParallelParse = false;
+        // -f[no-]eager-parse: parse every function body up front instead of when it's first needed
+        bool EagerParse = false;
+        // -f[no-]parallel-verify: type check function bodies on the thread pool
+        bool ParallelVerify = false;
+        // -f[no-]parallel-codegen: generate LLVM IR for partitions of the functions on the thread pool
+        bool ParallelCodegen = false;
+        // -f[no-]flat-ast: print the AST through its flat representation
+        bool FlatAST = false;
+        // -j<N>: number of worker threads, zero means one per hardware thread
+        uint32_t ThreadCount = 0;
+        // -O<N>: optimization level from 0 to 3
+        uint32_t OptLevel = 0;
+        // -ferror-limit=<N>: stop after N errors, zero means no limit
+        uint32_t ErrorLimit = 20;
     };
 
     class Session {
     public:
         static void Init(const std::vector<const char*>& args);
 
-        static bool IsGood() { return GetProperties().ErrorCount == 0; }
-        static uint32_t GetErrorCount() { return GetProperties().ErrorCount; }
+        static bool IsGood() { return GetErrorCount() == 0; }
+        static uint32_t GetErrorCount();
         static const char* const GetInputFile() { return GetProperties().InputFile; }
+        // Shared worker threads, started on first use
+        static ThreadPool& GetThreadPool();
+        // Diagnostics of the main thread, emitted when flushed
+        static DiagnosticEngine& GetDiagnostics();
 
         static void Trace(const std::string& message);
         static void Info(const std::string& message);
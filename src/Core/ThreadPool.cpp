@@ -0,0 +1,54 @@
+#include "scarpch.hpp"
+#include "Core/ThreadPool.hpp"
+
+namespace scar {
+
+    ThreadPool::ThreadPool(size_t threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        m_Threads.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; i++) {
+            m_Threads.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_Condition.notify_all();
+
+        for (auto& thread : m_Threads) {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::Push(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Tasks.push(std::move(task));
+        }
+        m_Condition.notify_one();
+    }
+
+    void ThreadPool::WorkerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Condition.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+                // Finish queued work before stopping
+                if (m_Tasks.empty()) {
+                    return;
+                }
+                task = std::move(m_Tasks.front());
+                m_Tasks.pop();
+            }
+            task();
+        }
+    }
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace scar {
+
+    // Fixed set of worker threads pulling tasks from a shared queue
+    class ThreadPool {
+    public:
+        // Zero threads means one per hardware thread
+        explicit ThreadPool(size_t threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        void operator=(const ThreadPool&) = delete;
+
+        size_t GetThreadCount() const { return m_Threads.size(); }
+
+        // Queue a task, the future holds its result or the exception it threw
+        template<typename Func>
+        auto Submit(Func&& func) -> std::future<decltype(func())> {
+            using Result = decltype(func());
+            auto task = MakeRef<std::packaged_task<Result()>>(std::forward<Func>(func));
+            std::future<Result> future = task->get_future();
+            Push([task]() { (*task)(); });
+            return future;
+        }
+
+        // Run func(i) for every i in [0, count) and wait until all of them are done.
+        // Exceptions are rethrown on the calling thread, lowest index first.
+        // Must not be called from a worker, it would wait on itself.
+        template<typename Func>
+        void ParallelFor(size_t count, Func&& func) {
+            std::vector<std::future<void>> futures;
+            futures.reserve(count);
+            for (size_t i = 0; i < count; i++) {
+                futures.push_back(Submit([&func, i]() { func(i); }));
+            }
+            for (auto& future : futures) {
+                future.wait();
+            }
+            for (auto& future : futures) {
+                future.get();
+            }
+        }
+
+    private:
+        std::vector<std::thread> m_Threads;
+        std::queue<std::function<void()>> m_Tasks;
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        bool m_Stopping = false;
+
+        void Push(std::function<void()> task);
+        void WorkerLoop();
+    };
+
+}
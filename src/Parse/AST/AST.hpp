@@ -1,4 +1,5 @@
 #pragma once
+#include "Parse/AST/ASTContext.hpp"
 #include "Parse/Token.hpp"
 
 namespace scar {
@@ -99,10 +100,10 @@ namespace scar {
         ///////////////////////////////////////////////////////////////////////
         // NODES
 
+        // Nodes live in an ASTContext and are never destroyed one by one
         class Node {
         public:
             Node(const TextSpan& span) : m_Span(span) {}
-            virtual ~Node() = default;
             virtual void Accept(Visitor& visitor) = 0;
             const TextSpan& GetSpan() const { return m_Span; }
         private:
@@ -133,11 +134,18 @@ namespace scar {
         ///////////////////////////////////////////////////////////////////////
         // SUPPORT
 
+        // Dense index of a declared name, assigned by the ResolveVisitor.
+        // Later passes keep their per-symbol data in arrays indexed by it.
+        using SymbolID = uint32_t;
+        static constexpr SymbolID NoSymbol = UINT32_MAX;
+
         struct Ident {
             const Interner::StringID StringID;
+            // The declaration's own SymbolID, or the one of the declaration it refers to
+            SymbolID Symbol = NoSymbol;
             Ident(Interner::StringID id, const TextSpan& span) :
                  StringID(id), m_Span(span) {}
-            const std::string& GetString() const { return Interner::GetString(StringID); }
+            std::string_view GetString() const { return Interner::GetString(StringID); }
             const TextSpan& GetSpan() const { return m_Span; }
         private:
             const TextSpan m_Span;
@@ -148,9 +156,9 @@ namespace scar {
         }
 
         struct Arg {
-            const Ident Name;
-            Ref<Type> VarType;
-            Arg(Ident name, const Ref<Type>& type, const TextSpan& span) :
+            Ident Name;
+            Type* VarType;
+            Arg(Ident name, Type* type, const TextSpan& span) :
                 Name(name), VarType(type), m_Span(span) {}
             const TextSpan& GetSpan() const { return m_Span; }
         private:
@@ -161,30 +169,58 @@ namespace scar {
         ///////////////////////////////////////////////////////////////////////
         // DECLARATIONS
 
+        // Tokens [Begin, End) of a function body the Parser skipped, it keeps them around
+        struct TokenRange {
+            uint32_t Begin = 0;
+            uint32_t End = 0;
+        };
+
+        // Parses the function bodies the Parser skipped, see Function::GetCodeBlock
+        class BodyParser {
+        public:
+            virtual Block* ParseBody(TokenRange tokens) = 0;
+        };
+
         class Module : public Stmt {
             SCAR_GENERATE_NODE;
         public:
-            const std::vector<Ref<Stmt>> Items;
-            Module(const std::vector<Ref<Stmt>>& items, const TextSpan& span) :
+            const List<Stmt*> Items;
+            // Number of SymbolIDs handed out by the ResolveVisitor
+            uint32_t SymbolCount = 0;
+            Module(List<Stmt*> items, const TextSpan& span) :
                 Stmt(span), Items(items) {}
         };
 
         class Function : public Stmt {
             SCAR_GENERATE_NODE;
         public:
-            Ref<FunctionPrototype> Prototype;
-            Ref<Block> CodeBlock;
-            Function(const Ref<FunctionPrototype>& prototype, const Ref<Block>& block, const TextSpan& span) :
-                Stmt(span), Prototype(prototype), CodeBlock(block) {}
+            FunctionPrototype* Prototype;
+            Function(FunctionPrototype* prototype, Block* block, const TextSpan& span) :
+                Stmt(span), Prototype(prototype), m_CodeBlock(block) {}
+            // The body was skipped, bodyParser parses it the first time it's asked for
+            Function(FunctionPrototype* prototype, BodyParser* bodyParser, TokenRange bodyTokens, const TextSpan& span) :
+                Stmt(span), Prototype(prototype), m_BodyParser(bodyParser), m_BodyTokens(bodyTokens) {}
+
+            Block* GetCodeBlock() {
+                if (!m_CodeBlock) {
+                    m_CodeBlock = m_BodyParser->ParseBody(m_BodyTokens);
+                }
+                return m_CodeBlock;
+            }
+            bool IsBodyParsed() const { return m_CodeBlock != nullptr; }
+        private:
+            Block* m_CodeBlock = nullptr;
+            BodyParser* m_BodyParser = nullptr;
+            TokenRange m_BodyTokens;
         };
 
         class FunctionPrototype : public Stmt {
             SCAR_GENERATE_NODE;
         public:
             Ident Name;
-            std::vector<Arg> Args;
-            Ref<Type> ReturnType;
-            FunctionPrototype(Ident name, const std::vector<Arg>& args, const Ref<Type>& retType, const TextSpan& span) :
+            List<Arg> Args;
+            Type* ReturnType;
+            FunctionPrototype(Ident name, List<Arg> args, Type* retType, const TextSpan& span) :
                 Stmt(span), Name(name), Args(args), ReturnType(retType) {}
         };
 
@@ -192,8 +228,8 @@ namespace scar {
             SCAR_GENERATE_NODE;
         public:
             Ident Name;
-            Ref<Type> VarType;
-            VarDecl(Ident name, const Ref<Type>& type, const TextSpan& span) :
+            Type* VarType;
+            VarDecl(Ident name, Type* type, const TextSpan& span) :
                 Expr(type->ResultType, span), Name(name), VarType(type) {}
         };
 
@@ -204,38 +240,38 @@ namespace scar {
         class Block : public Stmt {
             SCAR_GENERATE_NODE;
         public:
-            const std::vector<Ref<Stmt>> Items;
-            Block(const std::vector<Ref<Stmt>>& items, const TextSpan& span) :
+            const List<Stmt*> Items;
+            Block(List<Stmt*> items, const TextSpan& span) :
                 Stmt(span), Items(items) {}
         };
 
         class Branch : public Stmt {
             SCAR_GENERATE_NODE;
         public:
-            Ref<Expr> Condition;
-            Ref<Block> TrueBlock;
-            Ref<Block> FalseBlock;
-            Branch(const Ref<Expr>& cond, const Ref<Block>& trueBlock, const Ref<Block>& falseBlock, const TextSpan& span) :
+            Expr* Condition;
+            Block* TrueBlock;
+            Block* FalseBlock;
+            Branch(Expr* cond, Block* trueBlock, Block* falseBlock, const TextSpan& span) :
                 Stmt(span), Condition(cond), TrueBlock(trueBlock), FalseBlock(falseBlock) {}
         };
 
         class ForLoop : public Stmt {
             SCAR_GENERATE_NODE;
         public:
-            Ref<Expr> Init;
-            Ref<Expr> Condition;
-            Ref<Expr> Update;
-            Ref<Block> CodeBlock;
-            ForLoop(const Ref<Expr>& init, const Ref<Expr>& cond, const Ref<Expr>& update, const Ref<Block>& block, const TextSpan& span) :
+            Expr* Init;
+            Expr* Condition;
+            Expr* Update;
+            Block* CodeBlock;
+            ForLoop(Expr* init, Expr* cond, Expr* update, Block* block, const TextSpan& span) :
                 Stmt(span), Init(init), Condition(cond), Update(update), CodeBlock(block) {}
         };
 
         class WhileLoop : public Stmt {
             SCAR_GENERATE_NODE;
         public:
-            Ref<Expr> Condition;
-            Ref<Block> CodeBlock;
-            WhileLoop(const Ref<Expr>& cond, const Ref<Block>& block, const TextSpan& span) :
+            Expr* Condition;
+            Block* CodeBlock;
+            WhileLoop(Expr* cond, Block* block, const TextSpan& span) :
                 Stmt(span), Condition(cond), CodeBlock(block) {}
         };
 
@@ -254,8 +290,8 @@ namespace scar {
         class Return : public Stmt {
             SCAR_GENERATE_NODE;
         public:
-            Ref<Expr> Value;
-            Return(const Ref<Expr>& value, const TextSpan& span) :
+            Expr* Value;
+            Return(Expr* value, const TextSpan& span) :
                 Stmt(span), Value(value) {}
         };
 
@@ -267,8 +303,8 @@ namespace scar {
             SCAR_GENERATE_NODE;
         public:
             Ident Name;
-            std::vector<Ref<Expr>> Args;
-            FunctionCall(const Ident& name, const std::vector<Ref<Expr>>& args, const TextSpan& span) :
+            List<Expr*> Args;
+            FunctionCall(const Ident& name, List<Expr*> args, const TextSpan& span) :
                 Expr(TypeInfo::Invalid, span), Name(name), Args(args) {}
         };
 
@@ -297,8 +333,8 @@ namespace scar {
             };
 
             const OpType Type;
-            Ref<Expr> RHS;
-            PrefixOperator(PrefixOperator::OpType type, const Ref<Expr>& expr, const TextSpan& span) :
+            Expr* RHS;
+            PrefixOperator(PrefixOperator::OpType type, Expr* expr, const TextSpan& span) :
                 Expr(TypeInfo::Invalid, span), Type(type), RHS(expr) {}
         };
 
@@ -312,10 +348,10 @@ namespace scar {
             };
 
             const OpType Type;
-            Ref<Expr> LHS;
-            SuffixOperator(SuffixOperator::OpType type, const Ref<Expr>& expr, TypeInfo resultType, const TextSpan& span) :
+            Expr* LHS;
+            SuffixOperator(SuffixOperator::OpType type, Expr* expr, TypeInfo resultType, const TextSpan& span) :
                 Expr(resultType, span), Type(type), LHS(expr) {}
-            SuffixOperator(SuffixOperator::OpType type, const Ref<Expr>& expr, const TextSpan& span) :
+            SuffixOperator(SuffixOperator::OpType type, Expr* expr, const TextSpan& span) :
                 SuffixOperator(type, expr, TypeInfo::Invalid, span) {}
             
         };
@@ -345,9 +381,9 @@ namespace scar {
             };
 
             const OpType Type;
-            Ref<Expr> LHS;
-            Ref<Expr> RHS;
-            BinaryOperator(BinaryOperator::OpType type, const Ref<Expr>& lhs, const Ref<Expr>& rhs, const TextSpan& span) :
+            Expr* LHS;
+            Expr* RHS;
+            BinaryOperator(BinaryOperator::OpType type, Expr* lhs, Expr* rhs, const TextSpan& span) :
                 Expr(TypeInfo::Invalid, span), Type(type), LHS(lhs), RHS(rhs) {}
         };
 
@@ -0,0 +1,36 @@
+#include "scarpch.hpp"
+#include "Parse/AST/ASTContext.hpp"
+
+namespace scar {
+    namespace ast {
+
+        static constexpr size_t BlockSize = 64 * 1024;
+
+        void ASTContext::Merge(ASTContext& other) {
+            // Allocation carries on in our current block, wherever it ends up in the list
+            m_Blocks.insert(m_Blocks.end(),
+                            std::make_move_iterator(other.m_Blocks.begin()),
+                            std::make_move_iterator(other.m_Blocks.end()));
+
+            other.m_Blocks.clear();
+            other.m_Ptr = other.m_End = nullptr;
+        }
+
+        void* ASTContext::Allocate(size_t size, size_t align) {
+            size_t padding = (size_t)(-(uintptr_t)m_Ptr & (align - 1));
+            if (!m_Ptr || padding + size > (size_t)(m_End - m_Ptr)) {
+                // Oversized allocations get a block of their own
+                size_t blockSize = std::max(BlockSize, size + align);
+                m_Blocks.push_back(MakeScope<char[]>(blockSize));
+                m_Ptr = m_Blocks.back().get();
+                m_End = m_Ptr + blockSize;
+                padding = (size_t)(-(uintptr_t)m_Ptr & (align - 1));
+            }
+
+            void* ptr = m_Ptr + padding;
+            m_Ptr += padding + size;
+            return ptr;
+        }
+
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <type_traits>
+
+namespace scar {
+    namespace ast {
+
+        // Fixed size array of AST children, allocated in an ASTContext
+        template<typename T>
+        class List {
+        public:
+            List() = default;
+            List(T* data, size_t size) : m_Data(data), m_Size((uint32_t)size) {}
+
+            T& operator[](size_t index) const { return m_Data[index]; }
+            T* begin() const { return m_Data; }
+            T* end() const   { return m_Data + m_Size; }
+            size_t size() const { return m_Size; }
+            bool empty() const  { return m_Size == 0; }
+
+        private:
+            T* m_Data = nullptr;
+            uint32_t m_Size = 0;
+        };
+
+        // Owns every node of a Module. Nodes are bump allocated in large blocks and are
+        // all freed at once when the context is destroyed, so their destructors
+        // never run: nodes must be trivially destructible and link to each other with plain pointers.
+        class ASTContext {
+        public:
+            ASTContext() = default;
+
+            ASTContext(const ASTContext&) = delete;
+            void operator=(const ASTContext&) = delete;
+
+            template<typename T, typename... Args>
+            T* New(Args&&... args) {
+                static_assert(std::is_trivially_destructible_v<T>, "AST nodes are never destroyed");
+                return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            }
+
+            template<typename T>
+            List<T> NewList(const std::vector<T>& items) {
+                static_assert(std::is_trivially_destructible_v<T>, "AST nodes are never destroyed");
+                if (items.empty()) {
+                    return List<T>();
+                }
+                T* data = (T*)Allocate(sizeof(T) * items.size(), alignof(T));
+                std::uninitialized_copy(items.begin(), items.end(), data);
+                return List<T>(data, items.size());
+            }
+
+            // Take ownership of every node of other, which is left empty.
+            // Lets nodes be built in separate contexts on separate threads.
+            void Merge(ASTContext& other);
+
+        private:
+            std::vector<Scope<char[]>> m_Blocks;
+            char* m_Ptr = nullptr;
+            char* m_End = nullptr;
+
+            void* Allocate(size_t size, size_t align);
+        };
+
+    }
+}
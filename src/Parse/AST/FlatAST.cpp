@@ -0,0 +1,433 @@
+#include "scarpch.hpp"
+#include "Parse/AST/FlatAST.hpp"
+
+#include <cstring>
+
+namespace scar {
+    namespace ast {
+
+        using NodeIndex = FlatAST::NodeIndex;
+
+        FlatAST::NodeIndex FlatAST::AddNode(Kind kind, const TextSpan& span, TypeInfo type, uint8_t op) {
+            NodeIndex index = (NodeIndex)m_Kinds.size();
+            m_Kinds.push_back(kind);
+            m_Ops.push_back(op);
+            m_Types.push_back((uint8_t)type.Type);
+            m_Data.push_back({});
+            m_Spans.push_back(span);
+            return index;
+        }
+
+        uint64_t FlatAST::GetInt(NodeIndex node) const {
+            SCAR_ASSERT(GetKind(node) == LiteralInteger, "trying to get integer value from non-integer node!");
+            return m_Literals[m_Data[node].Lhs];
+        }
+
+        double FlatAST::GetFloat(NodeIndex node) const {
+            SCAR_ASSERT(GetKind(node) == LiteralFloat, "trying to get floating point value from non-float node!");
+            double value;
+            std::memcpy(&value, &m_Literals[m_Data[node].Lhs], sizeof(value));
+            return value;
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////////////////////////////////
+        // CONVERTER
+
+        // Walks the node tree once, adding every node before its children
+        class FlatASTBuilder : public Visitor {
+        public:
+            FlatAST Flat;
+
+            NodeIndex Build(Node* node) {
+                if (!node) {
+                    return FlatAST::NullNode;
+                }
+                node->Accept(*this);
+                return m_Result;
+            }
+
+            // Types are stored in their users' type byte
+            void Visit(Type& node) override {
+                m_Result = FlatAST::NullNode;
+            }
+
+            void Visit(Module& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::Module, node.GetSpan());
+                SetList(index, node.Items);
+                m_Result = index;
+            }
+
+            void Visit(Function& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::Function, node.GetSpan());
+                NodeIndex prototype = Build(node.Prototype);
+                NodeIndex block = node.IsBodyParsed() ? Build(node.GetCodeBlock()) : FlatAST::NullNode;
+                Flat.m_Data[index] = { prototype, block };
+                m_Result = index;
+            }
+
+            void Visit(FunctionPrototype& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::FunctionPrototype, node.GetSpan(), node.ReturnType->ResultType);
+
+                std::vector<uint32_t> args = { (uint32_t)node.Args.size() };
+                for (auto& arg : node.Args) {
+                    NodeIndex argIndex = Flat.AddNode(FlatAST::Arg, arg.GetSpan(), arg.VarType->ResultType);
+                    Flat.m_Data[argIndex] = { arg.Name.StringID, 0 };
+                    args.push_back(argIndex);
+                }
+
+                Flat.m_Data[index] = { node.Name.StringID, AddExtra(args) };
+                m_Result = index;
+            }
+
+            void Visit(VarDecl& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::VarDecl, node.GetSpan(), node.ResultType);
+                Flat.m_Data[index] = { node.Name.StringID, 0 };
+                m_Result = index;
+            }
+
+            void Visit(Branch& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::Branch, node.GetSpan());
+                NodeIndex cond = Build(node.Condition);
+                std::vector<uint32_t> blocks = { Build(node.TrueBlock), Build(node.FalseBlock) };
+                Flat.m_Data[index] = { cond, AddExtra(blocks) };
+                m_Result = index;
+            }
+
+            void Visit(ForLoop& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::ForLoop, node.GetSpan());
+                std::vector<uint32_t> header = { Build(node.Init), Build(node.Condition), Build(node.Update) };
+                NodeIndex block = Build(node.CodeBlock);
+                Flat.m_Data[index] = { AddExtra(header), block };
+                m_Result = index;
+            }
+
+            void Visit(WhileLoop& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::WhileLoop, node.GetSpan());
+                NodeIndex cond = Build(node.Condition);
+                NodeIndex block = Build(node.CodeBlock);
+                Flat.m_Data[index] = { cond, block };
+                m_Result = index;
+            }
+
+            void Visit(Block& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::Block, node.GetSpan());
+                SetList(index, node.Items);
+                m_Result = index;
+            }
+
+            void Visit(Continue& node) override {
+                m_Result = Flat.AddNode(FlatAST::Continue, node.GetSpan());
+            }
+
+            void Visit(Break& node) override {
+                m_Result = Flat.AddNode(FlatAST::Break, node.GetSpan());
+            }
+
+            void Visit(Return& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::Return, node.GetSpan());
+                NodeIndex value = Build(node.Value);
+                Flat.m_Data[index] = { value, 0 };
+                m_Result = index;
+            }
+
+            void Visit(FunctionCall& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::FunctionCall, node.GetSpan(), node.ResultType);
+
+                std::vector<uint32_t> args = { (uint32_t)node.Args.size() };
+                for (auto arg : node.Args) {
+                    args.push_back(Build(arg));
+                }
+
+                Flat.m_Data[index] = { node.Name.StringID, AddExtra(args) };
+                m_Result = index;
+            }
+
+            void Visit(VarAccess& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::VarAccess, node.GetSpan(), node.ResultType);
+                Flat.m_Data[index] = { node.Name.StringID, 0 };
+                m_Result = index;
+            }
+
+            void Visit(PrefixOperator& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::PrefixOperator, node.GetSpan(), node.ResultType, (uint8_t)node.Type);
+                NodeIndex rhs = Build(node.RHS);
+                Flat.m_Data[index] = { rhs, 0 };
+                m_Result = index;
+            }
+
+            void Visit(SuffixOperator& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::SuffixOperator, node.GetSpan(), node.ResultType, (uint8_t)node.Type);
+                NodeIndex lhs = Build(node.LHS);
+                Flat.m_Data[index] = { lhs, 0 };
+                m_Result = index;
+            }
+
+            void Visit(BinaryOperator& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::BinaryOperator, node.GetSpan(), node.ResultType, (uint8_t)node.Type);
+                NodeIndex lhs = Build(node.LHS);
+                NodeIndex rhs = Build(node.RHS);
+                Flat.m_Data[index] = { lhs, rhs };
+                m_Result = index;
+            }
+
+            void Visit(LiteralBool& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::LiteralBool, node.GetSpan(), node.ResultType);
+                Flat.m_Data[index] = { node.Value, 0 };
+                m_Result = index;
+            }
+
+            void Visit(LiteralInteger& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::LiteralInteger, node.GetSpan(), node.ResultType);
+                Flat.m_Data[index] = { (uint32_t)Flat.m_Literals.size(), 0 };
+                Flat.m_Literals.push_back(node.Value);
+                m_Result = index;
+            }
+
+            void Visit(LiteralFloat& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::LiteralFloat, node.GetSpan(), node.ResultType);
+                uint64_t bits;
+                std::memcpy(&bits, &node.Value, sizeof(bits));
+                Flat.m_Data[index] = { (uint32_t)Flat.m_Literals.size(), 0 };
+                Flat.m_Literals.push_back(bits);
+                m_Result = index;
+            }
+
+            void Visit(LiteralString& node) override {
+                NodeIndex index = Flat.AddNode(FlatAST::LiteralString, node.GetSpan(), node.ResultType);
+                Flat.m_Data[index] = { node.StringID, 0 };
+                m_Result = index;
+            }
+
+        private:
+            NodeIndex m_Result = FlatAST::NullNode;
+
+            uint32_t AddExtra(const std::vector<uint32_t>& values) {
+                uint32_t start = (uint32_t)Flat.m_Extra.size();
+                Flat.m_Extra.insert(Flat.m_Extra.end(), values.begin(), values.end());
+                return start;
+            }
+
+            // Children are built before the list is added, since they add lists of their own
+            void SetList(NodeIndex index, const List<Stmt*>& items) {
+                std::vector<uint32_t> children;
+                children.reserve(items.size());
+                for (auto item : items) {
+                    children.push_back(Build(item));
+                }
+                Flat.m_Data[index] = { AddExtra(children), (uint32_t)children.size() };
+            }
+        };
+
+        FlatAST FlatAST::FromTree(ast::Module& module) {
+            FlatASTBuilder builder;
+            builder.Build(&module);
+            return std::move(builder.Flat);
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////////////////////////////////
+        // PRINTER
+
+        class FlatASTPrinter {
+        public:
+            explicit FlatASTPrinter(const FlatAST& ast) : m_AST(ast) {}
+
+            void PrintNode(NodeIndex node) {
+                if (node == FlatAST::NullNode) {
+                    return;
+                }
+
+                const FlatAST::NodeData& data = m_AST.GetData(node);
+                TypeInfo type = m_AST.GetType(node);
+
+                switch (m_AST.GetKind(node)) {
+                case FlatAST::Module:
+                    Print(node, "Module");
+                    PrintList(m_AST.GetExtra(data.Lhs), data.Rhs);
+                    break;
+
+                case FlatAST::Function:
+                    Print(node, "Function");
+                    PrintNode(data.Lhs);
+                    EnableBranch(false);
+                    PrintNode(data.Rhs);
+                    break;
+
+                case FlatAST::FunctionPrototype: {
+                    Print(node, FMT("FunctionPrototype {} \"{}\"({})", type, Interner::GetString(data.Lhs), data.Lhs));
+                    // Args are printed with their prototype's span
+                    const uint32_t* args = m_AST.GetExtra(data.Rhs);
+                    for (uint32_t i = 0; i < args[0]; i++) {
+                        EnableBranch(i != args[0] - 1);
+                        NodeIndex arg = args[i + 1];
+                        Interner::StringID name = m_AST.GetData(arg).Lhs;
+                        PrintLine(node, FMT("Arg {} \"{}\"({})", m_AST.GetType(arg), Interner::GetString(name), name));
+                    }
+                    break;
+                }
+
+                case FlatAST::VarDecl:
+                    Print(node, FMT("VarDecl {} \"{}\"({})", type, Interner::GetString(data.Lhs), data.Lhs));
+                    break;
+
+                case FlatAST::Branch: {
+                    const uint32_t* blocks = m_AST.GetExtra(data.Rhs);
+                    Print(node, "Branch");
+                    PrintNode(data.Lhs);
+                    EnableBranch(blocks[1] != FlatAST::NullNode);
+                    PrintNode(blocks[0]);
+                    EnableBranch(false);
+                    PrintNode(blocks[1]);
+                    break;
+                }
+
+                case FlatAST::ForLoop: {
+                    const uint32_t* header = m_AST.GetExtra(data.Lhs);
+                    Print(node, "ForLoop");
+                    PrintNode(header[0]);
+                    PrintNode(header[1]);
+                    PrintNode(header[2]);
+                    EnableBranch(false);
+                    PrintNode(data.Rhs);
+                    break;
+                }
+
+                case FlatAST::WhileLoop:
+                    Print(node, "WhileLoop");
+                    PrintNode(data.Lhs);
+                    EnableBranch(false);
+                    PrintNode(data.Rhs);
+                    break;
+
+                case FlatAST::Block:
+                    Print(node, "Block");
+                    PrintList(m_AST.GetExtra(data.Lhs), data.Rhs);
+                    break;
+
+                case FlatAST::Continue:
+                    Print(node, "Continue");
+                    break;
+
+                case FlatAST::Break:
+                    Print(node, "Break");
+                    break;
+
+                case FlatAST::Return:
+                    Print(node, "Return");
+                    EnableBranch(false);
+                    PrintNode(data.Lhs);
+                    break;
+
+                case FlatAST::FunctionCall: {
+                    Print(node, FMT("FunctionCall {} \"{}\"({})", type, Interner::GetString(data.Lhs), data.Lhs));
+                    const uint32_t* args = m_AST.GetExtra(data.Rhs);
+                    PrintList(args + 1, args[0]);
+                    break;
+                }
+
+                case FlatAST::VarAccess:
+                    Print(node, FMT("VarAccess {} \"{}\"({})", type, Interner::GetString(data.Lhs), data.Lhs));
+                    break;
+
+                case FlatAST::PrefixOperator:
+                    Print(node, FMT("Prefix {}", (Token::TokenType)m_AST.GetOp(node)));
+                    EnableBranch(false);
+                    PrintNode(data.Lhs);
+                    break;
+
+                case FlatAST::SuffixOperator:
+                    if (m_AST.GetOp(node) == SuffixOperator::Cast) {
+                        Print(node, FMT("Cast {}", type));
+                    }
+                    else {
+                        Print(node, FMT("Suffix {}", (Token::TokenType)m_AST.GetOp(node)));
+                    }
+                    EnableBranch(false);
+                    PrintNode(data.Lhs);
+                    break;
+
+                case FlatAST::BinaryOperator:
+                    Print(node, FMT("Binary {}", (Token::TokenType)m_AST.GetOp(node)));
+                    PrintNode(data.Lhs);
+                    EnableBranch(false);
+                    PrintNode(data.Rhs);
+                    break;
+
+                case FlatAST::LiteralBool:
+                    Print(node, FMT("Bool {} {}", type, (bool)data.Lhs));
+                    break;
+
+                case FlatAST::LiteralInteger:
+                    Print(node, FMT("Int {} {}", type, m_AST.GetInt(node)));
+                    break;
+
+                case FlatAST::LiteralFloat:
+                    Print(node, FMT("Float {} {}", type, m_AST.GetFloat(node)));
+                    break;
+
+                case FlatAST::LiteralString:
+                    Print(node, FMT("String \"{}\"({})", Interner::GetString(data.Lhs), data.Lhs));
+                    break;
+
+                default:
+                    SCAR_BUG("missing print for FlatAST::Kind {}", (uint32_t)m_AST.GetKind(node));
+                    return;
+                }
+
+                // Close the scope opened by Print
+                m_IndentCount--;
+                m_BranchTracker.pop_back();
+            }
+
+        private:
+            const FlatAST& m_AST;
+            std::vector<bool> m_BranchTracker; // True enables pipe printing for that level
+            uint32_t m_IndentCount = 0;
+
+            void EnableBranch(bool enabled) {
+                m_BranchTracker.back() = enabled;
+            }
+
+            std::string GetIndent() const {
+                if (m_IndentCount == 0)
+                    return "";
+
+                std::string indent((size_t)m_IndentCount * 2, ' ');
+                for (size_t i = 1, j = 0; j < m_BranchTracker.size(); i += 2, j++) {
+                    if (m_BranchTracker[j])
+                        indent[i] = '|';
+                }
+                indent.back() = m_BranchTracker.back() ? '|' : '`';
+                return indent;
+            }
+
+            void PrintLine(NodeIndex node, const std::string& message) {
+                SCAR_TRACE("{}-{} <{}>", GetIndent(), message, m_AST.GetSpan(node));
+            }
+
+            // Print a node's line and open the scope of its children
+            void Print(NodeIndex node, const std::string& message) {
+                PrintLine(node, message);
+                m_IndentCount++;
+                m_BranchTracker.push_back(true);
+            }
+
+            void PrintList(const uint32_t* nodes, uint32_t count) {
+                for (uint32_t i = 0; i < count; i++) {
+                    EnableBranch(i != count - 1);
+                    PrintNode(nodes[i]);
+                }
+            }
+        };
+
+        void FlatAST::Print() const {
+            if (GetNodeCount() == 0) {
+                return;
+            }
+            FlatASTPrinter printer(*this);
+            printer.PrintNode(GetRoot());
+        }
+
+    }
+}
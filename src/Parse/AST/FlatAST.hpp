@@ -0,0 +1,99 @@
+#pragma once
+#include "Parse/AST/AST.hpp"
+
+namespace scar {
+    namespace ast {
+
+        // Data-oriented alternative to the node class hierarchy.
+        // Nodes live in parallel arrays and refer to their children by index,
+        // passes walk them with a switch on the node kind instead of virtual Accept calls.
+        class FlatAST {
+        public:
+            using NodeIndex = uint32_t;
+            static constexpr NodeIndex NullNode = UINT32_MAX;
+
+            enum Kind : uint8_t {
+                Module,
+                Function,
+                FunctionPrototype,
+                Arg,
+                VarDecl,
+
+                Branch,
+                ForLoop,
+                WhileLoop,
+                Block,
+                Continue,
+                Break,
+                Return,
+
+                FunctionCall,
+                VarAccess,
+
+                PrefixOperator,
+                SuffixOperator,
+                BinaryOperator,
+
+                LiteralBool,
+                LiteralInteger,
+                LiteralFloat,
+                LiteralString,
+            };
+
+            // Meaning of each kind's two data words, lists live in the extra array:
+            //   Module, Block      Lhs: extra index of the items     Rhs: item count
+            //   Function           Lhs: prototype                    Rhs: block, NullNode if never parsed
+            //   FunctionPrototype  Lhs: name                         Rhs: extra index of [count, args...]
+            //   Arg, VarDecl       Lhs: name
+            //   Branch             Lhs: condition                    Rhs: extra index of [true block, false block]
+            //   ForLoop            Lhs: extra index of [init, condition, update]  Rhs: block
+            //   WhileLoop          Lhs: condition                    Rhs: block
+            //   Return             Lhs: value or NullNode
+            //   FunctionCall       Lhs: name                         Rhs: extra index of [count, args...]
+            //   VarAccess          Lhs: name
+            //   Prefix/Suffix      Lhs: operand
+            //   BinaryOperator     Lhs: left operand                 Rhs: right operand
+            //   LiteralBool        Lhs: value
+            //   LiteralInteger     Lhs: literal index
+            //   LiteralFloat       Lhs: literal index, the literal holds the double's bits
+            //   LiteralString      Lhs: StringID
+            struct NodeData {
+                uint32_t Lhs = 0;
+                uint32_t Rhs = 0;
+            };
+
+            // Flatten a tree built by the Parser, the Module becomes the root node
+            static FlatAST FromTree(ast::Module& module);
+
+            NodeIndex GetRoot() const    { return 0; }
+            size_t GetNodeCount() const  { return m_Kinds.size(); }
+
+            Kind GetKind(NodeIndex node) const             { return (Kind)m_Kinds[node]; }
+            // Operator of operator nodes, it's the operator's Token::TokenType
+            uint8_t GetOp(NodeIndex node) const            { return m_Ops[node]; }
+            TypeInfo GetType(NodeIndex node) const         { return (TypeInfo::Ty)m_Types[node]; }
+            const NodeData& GetData(NodeIndex node) const  { return m_Data[node]; }
+            const TextSpan& GetSpan(NodeIndex node) const  { return m_Spans[node]; }
+            const uint32_t* GetExtra(uint32_t index) const { return m_Extra.data() + index; }
+
+            uint64_t GetInt(NodeIndex node) const;
+            double GetFloat(NodeIndex node) const;
+
+            // Trace the tree in the same format as PrintVisitor
+            void Print() const;
+
+        private:
+            std::vector<uint8_t> m_Kinds;
+            std::vector<uint8_t> m_Ops;
+            std::vector<uint8_t> m_Types;
+            std::vector<NodeData> m_Data;
+            std::vector<TextSpan> m_Spans;
+            std::vector<uint32_t> m_Extra;
+            std::vector<uint64_t> m_Literals;
+
+            friend class FlatASTBuilder;
+            NodeIndex AddNode(Kind kind, const TextSpan& span, TypeInfo type = TypeInfo::Invalid, uint8_t op = 0);
+        };
+
+    }
+}
@@ -1,6 +1,6 @@
 #include "scarpch.hpp"
 #include "Parse/AST/LLVMVisitor.hpp"
-#include "Parse/AST/SymbolTable.hpp"
+#include "Core/ThreadPool.hpp"
 
 #ifdef _MSC_VER
     #pragma warning(push, 0)
@@ -17,18 +17,23 @@
 #include <llvm/IR/Type.h>
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Verifier.h>
-#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/MC/SubtargetFeature.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Target/TargetMachine.h>
 #include <llvm/ADT/APFloat.h>
 #include <llvm/ADT/STLExtras.h>
-#include <llvm/Transforms/InstCombine/InstCombine.h>
-#include <llvm/Transforms/Scalar/GVN.h>
-#include <llvm/Transforms/Scalar.h>
-#include "llvm/Transforms/Utils.h"
 #ifdef _MSC_VER
     #pragma warning(pop)
 #endif
 
-#define SPAN_ERROR(msg, span) SCAR_ERROR("{}: {}", span, msg)
+#define SPAN_ERROR(span, ...) m_Diagnostics.Report(span, __VA_ARGS__)
 
 namespace scar {
     namespace ast {
@@ -40,24 +45,6 @@ namespace scar {
         struct LLVMVisitorSymbol {
             llvm::AllocaInst* Alloca = nullptr;
             llvm::Type* Type= nullptr;
-            llvm::StringRef Name;
-        };
-        class LLVMVisitorSymbolTable : public SymbolTable<std::string, LLVMVisitorSymbol> {
-        public:
-            LLVMVisitorSymbolTable() = default;
-            ~LLVMVisitorSymbolTable() = default;
-
-            void Add(const Ident& key, llvm::AllocaInst* val) { Add(key.GetString(), val); }
-            void Add(const std::string& key, llvm::AllocaInst* val) {
-                m_Symbols.back()[key] = LLVMVisitorSymbol{ val, val->getAllocatedType(), val->getName() };
-            }
-
-            const LLVMVisitorSymbol& Find(const Ident& key) const { return Find(key.GetString()); }
-            const LLVMVisitorSymbol& Find(const std::string& key) const {
-                auto ret = TryFind(key);
-                if (!ret) SCAR_CRITICAL("Symbol '{}' not found in SymbolTable!", key);
-                return *ret;
-            }
         };
 
         struct LoopBlocks {
@@ -69,10 +56,12 @@ namespace scar {
         struct LLVMVisitorData {
             llvm::LLVMContext Context;
             Scope<llvm::IRBuilder<>> Builder;
-            Scope<llvm::legacy::FunctionPassManager> FunctionPassManager;
             Scope<llvm::Module> Module;
+            // Null if the host isn't a target LLVM was built with
+            Scope<llvm::TargetMachine> Target;
 
-            LLVMVisitorSymbolTable Symbols;
+            // Variable of each symbol, indexed by SymbolID
+            std::vector<LLVMVisitorSymbol> Symbols;
             std::vector<LoopBlocks> LoopStack;
             bool BlockReturned = false;
 
@@ -81,30 +70,29 @@ namespace scar {
             llvm::Value* RetValue = nullptr;
             llvm::Type* RetType = nullptr;
         };
-        static LLVMVisitorData s_Data;
 
         ///////////////////////////////////////////////////////////////////////
         ///////////////////////////////////////////////////////////////////////
         // SUPPORT
 
-        static llvm::Type* LLVMType(TypeInfo type) {
+        static llvm::Type* LLVMType(llvm::LLVMContext& context, TypeInfo type) {
             switch (type) {
-            case TypeInfo::Void: return llvm::Type::getVoidTy(s_Data.Context);
+            case TypeInfo::Void: return llvm::Type::getVoidTy(context);
 
-            case TypeInfo::Bool: return llvm::Type::getInt1Ty(s_Data.Context);
+            case TypeInfo::Bool: return llvm::Type::getInt1Ty(context);
 
-            case TypeInfo::I8:  return llvm::Type::getInt8Ty(s_Data.Context);
-            case TypeInfo::I16: return llvm::Type::getInt16Ty(s_Data.Context);
-            case TypeInfo::I32: return llvm::Type::getInt32Ty(s_Data.Context);
-            case TypeInfo::I64: return llvm::Type::getInt64Ty(s_Data.Context);
+            case TypeInfo::I8:  return llvm::Type::getInt8Ty(context);
+            case TypeInfo::I16: return llvm::Type::getInt16Ty(context);
+            case TypeInfo::I32: return llvm::Type::getInt32Ty(context);
+            case TypeInfo::I64: return llvm::Type::getInt64Ty(context);
 
-            case TypeInfo::U8:  return llvm::Type::getInt8Ty(s_Data.Context);
-            case TypeInfo::U16: return llvm::Type::getInt16Ty(s_Data.Context);
-            case TypeInfo::U32: return llvm::Type::getInt32Ty(s_Data.Context);
-            case TypeInfo::U64: return llvm::Type::getInt64Ty(s_Data.Context);
+            case TypeInfo::U8:  return llvm::Type::getInt8Ty(context);
+            case TypeInfo::U16: return llvm::Type::getInt16Ty(context);
+            case TypeInfo::U32: return llvm::Type::getInt32Ty(context);
+            case TypeInfo::U64: return llvm::Type::getInt64Ty(context);
 
-            case TypeInfo::F32: return llvm::Type::getFloatTy(s_Data.Context);
-            case TypeInfo::F64: return llvm::Type::getDoubleTy(s_Data.Context);
+            case TypeInfo::F32: return llvm::Type::getFloatTy(context);
+            case TypeInfo::F64: return llvm::Type::getDoubleTy(context);
 
             case TypeInfo::Char:
                 SCAR_BUG("missing llvm::Type for Type::Char");
@@ -168,30 +156,77 @@ namespace scar {
             return false;
         }
 
+        // The optimizer needs the target to know which vector widths and instructions are worth using
+        static Scope<llvm::TargetMachine> CreateHostTargetMachine() {
+            static std::once_flag s_InitFlag;
+            std::call_once(s_InitFlag, []() {
+                llvm::InitializeNativeTarget();
+            });
+
+            std::string triple = llvm::sys::getDefaultTargetTriple();
+            std::string error;
+            const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, error);
+            if (!target) {
+                SCAR_WARN("no target for {}, optimizing without target information: {}", triple, error);
+                return nullptr;
+            }
+
+            llvm::SubtargetFeatures features;
+            llvm::StringMap<bool> hostFeatures;
+            if (llvm::sys::getHostCPUFeatures(hostFeatures)) {
+                for (auto& feature : hostFeatures) {
+                    features.AddFeature(feature.first(), feature.second);
+                }
+            }
+            return Scope<llvm::TargetMachine>(target->createTargetMachine(triple, llvm::sys::getHostCPUName(), features.getString(), llvm::TargetOptions(), llvm::None));
+        }
+
         ///////////////////////////////////////////////////////////////////////
         ///////////////////////////////////////////////////////////////////////
         // VISITOR
 
-        LLVMVisitor::LLVMVisitor() {
-            s_Data.Module = MakeScope<llvm::Module>("test_module", s_Data.Context);
-            s_Data.Builder = MakeScope<llvm::IRBuilder<>>(s_Data.Context);
+        LLVMVisitor::LLVMVisitor(DiagnosticEngine& diagnostics) :
+            m_Diagnostics(diagnostics), m_Data(MakeScope<LLVMVisitorData>())
+        {
+            m_Data->Module = MakeScope<llvm::Module>("test_module", m_Data->Context);
+            m_Data->Builder = MakeScope<llvm::IRBuilder<>>(m_Data->Context);
 
-            s_Data.FunctionPassManager = MakeScope<llvm::legacy::FunctionPassManager>(s_Data.Module.get());
-            s_Data.FunctionPassManager->add(llvm::createPromoteMemoryToRegisterPass());
-            s_Data.FunctionPassManager->add(llvm::createInstructionCombiningPass());
-            s_Data.FunctionPassManager->add(llvm::createReassociatePass());
-            s_Data.FunctionPassManager->add(llvm::createGVNPass());
-            s_Data.FunctionPassManager->add(llvm::createCFGSimplificationPass());
-            s_Data.FunctionPassManager->doInitialization();
+            m_Data->Target = CreateHostTargetMachine();
+            if (m_Data->Target) {
+                m_Data->Module->setTargetTriple(m_Data->Target->getTargetTriple().str());
+                m_Data->Module->setDataLayout(m_Data->Target->createDataLayout());
+            }
         }
 
+        LLVMVisitor::~LLVMVisitor() = default;
+
         void LLVMVisitor::Print() const {
-            s_Data.Module->print(llvm::outs(), nullptr);
+            m_Data->Module->print(llvm::outs(), nullptr);
         }
 
-        static llvm::AllocaInst* CreateEntryAlloca(llvm::Function* func, llvm::Type* type, llvm::StringRef name)  {
+        static llvm::AllocaInst* CreateEntryAlloca(LLVMVisitorData& data, llvm::Function* func, llvm::Type* type, llvm::StringRef name)  {
             llvm::IRBuilder<> builder = llvm::IRBuilder<>(&func->getEntryBlock(), func->getEntryBlock().begin());
-            return s_Data.Builder->CreateAlloca(type, 0, name);
+            return data.Builder->CreateAlloca(type, 0, name);
+        }
+
+        // Drop a function that failed, it stays declared if something calls it
+        static void DiscardFunction(llvm::Function* func) {
+            if (func->use_empty()) {
+                func->eraseFromParent();
+            }
+            else {
+                func->deleteBody();
+            }
+        }
+
+        static void AddSymbol(LLVMVisitorData& data, const Ident& name, llvm::AllocaInst* alloc) {
+            data.Symbols[name.Symbol] = { alloc, alloc->getAllocatedType() };
+        }
+
+        static const LLVMVisitorSymbol& FindSymbol(LLVMVisitorData& data, const Ident& name) {
+            if (name.Symbol == NoSymbol || !data.Symbols[name.Symbol].Alloca)
+                SCAR_CRITICAL("Symbol '{}' has no variable!", name.GetString());
+            return data.Symbols[name.Symbol];
         }
 
         ///////////////////////////////////////////////////////////////////////
@@ -199,68 +234,205 @@ namespace scar {
         // TYPE
 
         void LLVMVisitor::Visit(Type& node) {
-            s_Data.RetType = LLVMType(node.ResultType);
+            m_Data->RetType = LLVMType(m_Data->Context, node.ResultType);
         }
 
         ///////////////////////////////////////////////////////////////////////
         ///////////////////////////////////////////////////////////////////////
         // DECLARATIONS
 
+        // Module items are either Functions or their declarations
+        static FunctionPrototype* ItemPrototype(Stmt* item) {
+            if (auto function = dynamic_cast<Function*>(item)) {
+                return function->Prototype;
+            }
+            return dynamic_cast<FunctionPrototype*>(item);
+        }
+
+        // Every function can be called before its definition, so they're all declared up front
+        void LLVMVisitor::DeclareFunctions(Module& node) {
+            for (auto& item : node.Items) {
+                FunctionPrototype* prototype = ItemPrototype(item);
+                if (prototype && !m_Data->Module->getFunction(prototype->Name.GetString())) {
+                    prototype->Accept(*this);
+                }
+            }
+        }
+
         void LLVMVisitor::Visit(Module& node) {
+            // Functions whose body was never reached are only declared, like prototypes
+            std::vector<Function*> functions;
             for (auto& item : node.Items) {
-                item->Accept(*this);
+                auto function = dynamic_cast<Function*>(item);
+                if (function && function->IsBodyParsed()) {
+                    functions.push_back(function);
+                }
+            }
+
+            if (GenerateParallel(node, functions)) {
+                return;
+            }
+
+            m_Data->Symbols.assign(node.SymbolCount, {});
+            DeclareFunctions(node);
+            for (Function* function : functions) {
+                function->Accept(*this);
+            }
+
+            if (!m_Diagnostics.HasErrors()) {
+                Optimize();
             }
         }
 
+        void LLVMVisitor::Optimize() {
+            llvm::OptimizationLevel level;
+            switch (Session::GetProperties().OptLevel) {
+            case 0: return;
+            case 1: level = llvm::OptimizationLevel::O1; break;
+            case 2: level = llvm::OptimizationLevel::O2; break;
+            default: level = llvm::OptimizationLevel::O3; break;
+            }
+
+            // Declared in this order so they're destroyed from the module down
+            llvm::LoopAnalysisManager loopAnalyses;
+            llvm::FunctionAnalysisManager functionAnalyses;
+            llvm::CGSCCAnalysisManager sccAnalyses;
+            llvm::ModuleAnalysisManager moduleAnalyses;
+
+            llvm::PassBuilder builder(m_Data->Target.get());
+            builder.registerModuleAnalyses(moduleAnalyses);
+            builder.registerCGSCCAnalyses(sccAnalyses);
+            builder.registerFunctionAnalyses(functionAnalyses);
+            builder.registerLoopAnalyses(loopAnalyses);
+            builder.crossRegisterProxies(loopAnalyses, functionAnalyses, sccAnalyses, moduleAnalyses);
+
+            llvm::ModulePassManager passes = builder.buildPerModuleDefaultPipeline(level);
+            passes.run(*m_Data->Module, moduleAnalyses);
+        }
+
+        bool LLVMVisitor::GenerateParallel(Module& node, const std::vector<Function*>& functions) {
+            if (!Session::GetProperties().ParallelCodegen || functions.size() <= 1 || Session::GetThreadPool().GetThreadCount() <= 1) {
+                return false;
+            }
+
+            // Each partition is a contiguous range of functions generated into its own LLVMContext,
+            // it's handed back as bitcode since modules can only be linked within a single context
+            ThreadPool& pool = Session::GetThreadPool();
+            size_t partitionCount = std::min(functions.size(), pool.GetThreadCount());
+            std::vector<DiagnosticEngine> diagnostics(partitionCount);
+            std::vector<llvm::SmallVector<char, 0>> bitcodes(partitionCount);
+            pool.ParallelFor(partitionCount, [&](size_t i) {
+                LLVMVisitor codegen(diagnostics[i]);
+                codegen.m_Data->Symbols.assign(node.SymbolCount, {});
+                codegen.DeclareFunctions(node);
+
+                size_t end = functions.size() * (i + 1) / partitionCount;
+                for (size_t j = functions.size() * i / partitionCount; j < end; j++) {
+                    functions[j]->Accept(codegen);
+                }
+
+                // Partitions are optimized on their own, so calls between them are never inlined
+                if (!diagnostics[i].HasErrors()) {
+                    codegen.Optimize();
+                    llvm::raw_svector_ostream stream(bitcodes[i]);
+                    llvm::WriteBitcodeToFile(*codegen.m_Data->Module, stream);
+                }
+            });
+
+            // Partitions are contiguous, appending them in order keeps the diagnostics in source order
+            for (DiagnosticEngine& partition : diagnostics) {
+                m_Diagnostics.Append(partition);
+            }
+            if (m_Diagnostics.HasErrors()) {
+                return true;
+            }
+
+            // Declared up front like the sequential path does, so functions no partition defines are kept
+            DeclareFunctions(node);
+            llvm::Linker linker(*m_Data->Module);
+            for (size_t i = 0; i < partitionCount; i++) {
+                llvm::SmallVector<char, 0>& bitcode = bitcodes[i];
+                llvm::MemoryBufferRef buffer(llvm::StringRef(bitcode.data(), bitcode.size()), "partition");
+                llvm::Expected<std::unique_ptr<llvm::Module>> partition = llvm::parseBitcodeFile(buffer, m_Data->Context);
+                if (!partition) {
+                    m_Diagnostics.Report(DiagID::CodegenLinkFailed, llvm::toString(partition.takeError()));
+                    return true;
+                }
+                if (linker.linkInModule(std::move(*partition))) {
+                    m_Diagnostics.Report(DiagID::CodegenLinkFailed, fmt::format("partition {} of {}", i + 1, partitionCount));
+                    return true;
+                }
+            }
+
+            // A function its partition discarded is left as a declaration, drop it if nothing calls it
+            for (Function* function : functions) {
+                llvm::Function* func = m_Data->Module->getFunction(function->Prototype->Name.GetString());
+                if (func && func->isDeclaration()) {
+                    DiscardFunction(func);
+                }
+            }
+
+            // Put the functions back in the order they were first declared, the linker adds them as they're referenced.
+            // Going backwards and moving each one to the front leaves the first declaration of a name last.
+            auto& functionList = m_Data->Module->getFunctionList();
+            for (auto item = node.Items.end(); item != node.Items.begin();) {
+                FunctionPrototype* prototype = ItemPrototype(*--item);
+                if (llvm::Function* func = prototype ? m_Data->Module->getFunction(prototype->Name.GetString()) : nullptr) {
+                    functionList.splice(functionList.begin(), functionList, func->getIterator());
+                }
+            }
+            return true;
+        }
+
         void LLVMVisitor::Visit(Function& node) {
-            llvm::Function* func = s_Data.Module->getFunction(node.Prototype->Name.GetString());
+            llvm::Function* func = m_Data->Module->getFunction(node.Prototype->Name.GetString());
 
             // Generate prototype if not already declared
             if (!func) {
                 node.Prototype->Accept(*this);
-                func = llvm::cast<llvm::Function>(s_Data.RetValue);
+                func = llvm::cast<llvm::Function>(m_Data->RetValue);
 
                 if (!func) {
-                    s_Data.RetValue = nullptr;
+                    m_Data->RetValue = nullptr;
                     return;
                 }
             }
 
-            llvm::BasicBlock* block = llvm::BasicBlock::Create(s_Data.Context, "entry", func);
+            // An earlier declaration may not match the definition
+            if (func->arg_size() != node.Prototype->Args.size()) {
+                SPAN_ERROR(node.Prototype->GetSpan(), DiagID::ArgumentCountMismatch, node.Prototype->Name);
+                m_Data->RetValue = nullptr;
+                return;
+            }
 
-            s_Data.Symbols.PushScope();
-            s_Data.Builder->SetInsertPoint(block);
+            llvm::BasicBlock* block = llvm::BasicBlock::Create(m_Data->Context, "entry", func);
+            m_Data->Builder->SetInsertPoint(block);
 
-            // Add argument names to symbol table
-            for (auto& arg : func->args()) {
-                llvm::AllocaInst* alloc = CreateEntryAlloca(func, arg.getType(), arg.getName());
-                s_Data.Builder->CreateStore(&arg, alloc);
-                s_Data.Symbols.Add(arg.getName().str(), alloc);
+            // Give every argument a variable
+            for (size_t i = 0; i < node.Prototype->Args.size(); i++) {
+                llvm::Argument* arg = func->getArg((unsigned int)i);
+                llvm::AllocaInst* alloc = CreateEntryAlloca(*m_Data, func, arg->getType(), arg->getName());
+                m_Data->Builder->CreateStore(arg, alloc);
+                AddSymbol(*m_Data, node.Prototype->Args[i].Name, alloc);
             }
 
-            node.CodeBlock->Accept(*this);
-            s_Data.BlockReturned = false;
-
-            s_Data.Symbols.PopScope();
+            node.GetCodeBlock()->Accept(*this);
+            m_Data->BlockReturned = false;
 
             // Make sure we have a return value
-            if (!s_Data.RetValue) {
-                func->eraseFromParent();
+            if (!m_Data->RetValue) {
+                DiscardFunction(func);
                 return;
             }
 
             // Verify function code
             if (llvm::verifyFunction(*func, &llvm::errs())) {
-                func->eraseFromParent();
-                s_Data.RetValue = nullptr;
+                DiscardFunction(func);
+                m_Data->RetValue = nullptr;
                 return;
             }
-#ifdef SCAR_RELEASE
-            // Optimize function
-            s_Data.FunctionPassManager->run(*func);
-#endif
 
-            s_Data.RetValue = func;
+            m_Data->RetValue = func;
         }
 
         void LLVMVisitor::Visit(FunctionPrototype& node) {
@@ -269,34 +441,34 @@ namespace scar {
             argTypes.reserve(node.Args.size());
             for (auto& arg : node.Args) {
                 arg.VarType->Accept(*this);
-                argTypes.push_back(s_Data.RetType);
+                argTypes.push_back(m_Data->RetType);
             }
             // Return type
             node.ReturnType->Accept(*this);
-            llvm::Type* retType = s_Data.RetType;
+            llvm::Type* retType = m_Data->RetType;
 
             // Create function
             llvm::FunctionType* funcType = llvm::FunctionType::get(retType, argTypes, false);
-            llvm::Function* func = llvm::Function::Create(funcType, llvm::Function::ExternalLinkage, node.Name.GetString(), *s_Data.Module);
+            llvm::Function* func = llvm::Function::Create(funcType, llvm::Function::ExternalLinkage, node.Name.GetString(), *m_Data->Module);
 
             // Set argument names
             unsigned int index = 0;
             for (auto& arg : func->args()) {
-                arg.setName(node.Args[index].Name.GetString());
+                arg.setName(node.Args[index++].Name.GetString());
             }
 
-            s_Data.RetValue = func;
+            m_Data->RetValue = func;
             return;
         }
 
         void LLVMVisitor::Visit(VarDecl& node) {
-            llvm::Function* func = s_Data.Builder->GetInsertBlock()->getParent();
+            llvm::Function* func = m_Data->Builder->GetInsertBlock()->getParent();
 
             node.VarType->Accept(*this);
-            llvm::AllocaInst* alloc = CreateEntryAlloca(func, s_Data.RetType, node.Name.GetString());
-            s_Data.Symbols.Add(node.Name, alloc);
+            llvm::AllocaInst* alloc = CreateEntryAlloca(*m_Data, func, m_Data->RetType, node.Name.GetString());
+            AddSymbol(*m_Data, node.Name, alloc);
 
-            s_Data.RetAlloca = alloc;
+            m_Data->RetAlloca = alloc;
         }
 
         ///////////////////////////////////////////////////////////////////////
@@ -304,147 +476,144 @@ namespace scar {
         // STATEMENTS
 
         void LLVMVisitor::Visit(Branch& node) {
-            llvm::Function* func = s_Data.Builder->GetInsertBlock()->getParent();
-
-            llvm::BasicBlock* trueBlock = llvm::BasicBlock::Create(s_Data.Context, "branch.true", func);
-            llvm::BasicBlock* falseBlock = llvm::BasicBlock::Create(s_Data.Context, "branch.false", func);
-            llvm::BasicBlock* exitBlock = llvm::BasicBlock::Create(s_Data.Context, "branch.exit");
+            llvm::Function* func = m_Data->Builder->GetInsertBlock()->getParent();
 
-            s_Data.Symbols.PushScope();
+            llvm::BasicBlock* trueBlock = llvm::BasicBlock::Create(m_Data->Context, "branch.true", func);
+            llvm::BasicBlock* falseBlock = llvm::BasicBlock::Create(m_Data->Context, "branch.false", func);
+            llvm::BasicBlock* exitBlock = llvm::BasicBlock::Create(m_Data->Context, "branch.exit");
 
             node.Condition->Accept(*this);
-            s_Data.Builder->CreateCondBr(s_Data.RetValue, trueBlock, falseBlock);
+            m_Data->Builder->CreateCondBr(m_Data->RetValue, trueBlock, falseBlock);
 
             bool needExit = false;
 
             // True block
-            s_Data.Builder->SetInsertPoint(trueBlock);
+            m_Data->Builder->SetInsertPoint(trueBlock);
             node.TrueBlock->Accept(*this);
-            if (!s_Data.BlockReturned) {
-                s_Data.Builder->CreateBr(exitBlock);
+            if (!m_Data->BlockReturned) {
+                m_Data->Builder->CreateBr(exitBlock);
                 needExit |= true;
             }
-            s_Data.BlockReturned = false;
-            trueBlock = s_Data.Builder->GetInsertBlock();
-
-            s_Data.Symbols.PopScope();
-            s_Data.Symbols.PushScope();
+            m_Data->BlockReturned = false;
+            trueBlock = m_Data->Builder->GetInsertBlock();
 
             // False block
-            s_Data.Builder->SetInsertPoint(falseBlock);
+            m_Data->Builder->SetInsertPoint(falseBlock);
             node.FalseBlock->Accept(*this);
-            if (!s_Data.BlockReturned) {
-                s_Data.Builder->CreateBr(exitBlock);
+            if (!m_Data->BlockReturned) {
+                m_Data->Builder->CreateBr(exitBlock);
                 needExit |= true;
             }
-            s_Data.BlockReturned = false;
-            falseBlock = s_Data.Builder->GetInsertBlock();
+            m_Data->BlockReturned = false;
+            falseBlock = m_Data->Builder->GetInsertBlock();
 
             // Exit
-            s_Data.Symbols.PopScope();
-
             if (needExit) {
                 func->getBasicBlockList().push_back(exitBlock);
-                s_Data.Builder->SetInsertPoint(exitBlock);
+                m_Data->Builder->SetInsertPoint(exitBlock);
 
                 // Merge branch return value
-                /*llvm::PHINode* phi = s_Data.Builder->CreatePHI(llvm::Type::getDoubleTy(s_Data.Context), (unsigned int)mergers.size(), "merge");
+                /*llvm::PHINode* phi = m_Data->Builder->CreatePHI(llvm::Type::getDoubleTy(m_Data->Context), (unsigned int)mergers.size(), "merge");
                 for (auto& merger : mergers) {
                     phi->addIncoming(merger.first, merger.second);
                 }
-                s_Data.ReturnValue = phi;*/
+                m_Data->ReturnValue = phi;*/
             }
             else {
-                s_Data.BlockReturned = true;
+                m_Data->BlockReturned = true;
             }
         }
 
         void LLVMVisitor::Visit(ForLoop& node) {
-            llvm::Function* func = s_Data.Builder->GetInsertBlock()->getParent();
-
-            llvm::BasicBlock* headerBlock = llvm::BasicBlock::Create(s_Data.Context, "loop.header", func);
-            llvm::BasicBlock* bodyBlock = llvm::BasicBlock::Create(s_Data.Context, "loop.body", func);
-            llvm::BasicBlock* exitBlock = llvm::BasicBlock::Create(s_Data.Context, "loop.exit", func);
-            s_Data.LoopStack.push_back({ headerBlock, exitBlock });
+            llvm::Function* func = m_Data->Builder->GetInsertBlock()->getParent();
 
-            s_Data.Symbols.PushScope();
+            llvm::BasicBlock* headerBlock = llvm::BasicBlock::Create(m_Data->Context, "loop.header", func);
+            llvm::BasicBlock* bodyBlock = llvm::BasicBlock::Create(m_Data->Context, "loop.body", func);
+            llvm::BasicBlock* exitBlock = llvm::BasicBlock::Create(m_Data->Context, "loop.exit", func);
+            m_Data->LoopStack.push_back({ headerBlock, exitBlock });
 
-            node.Init->Accept(*this);
-            s_Data.Builder->CreateBr(headerBlock);
+            if (node.Init) {
+                node.Init->Accept(*this);
+            }
+            m_Data->Builder->CreateBr(headerBlock);
 
             // Header block
-            s_Data.Builder->SetInsertPoint(headerBlock);
+            m_Data->Builder->SetInsertPoint(headerBlock);
             node.Condition->Accept(*this);
-            s_Data.Builder->CreateCondBr(s_Data.RetValue, bodyBlock, exitBlock);
+            m_Data->Builder->CreateCondBr(m_Data->RetValue, bodyBlock, exitBlock);
 
             // Body block
-            s_Data.Builder->SetInsertPoint(bodyBlock);
+            m_Data->Builder->SetInsertPoint(bodyBlock);
             node.CodeBlock->Accept(*this);
-            if (!s_Data.BlockReturned) {
-                node.Update->Accept(*this);
-                s_Data.Builder->CreateBr(headerBlock);
+            if (!m_Data->BlockReturned) {
+                if (node.Update) {
+                    node.Update->Accept(*this);
+                }
+                m_Data->Builder->CreateBr(headerBlock);
             }
-            s_Data.BlockReturned = false;
+            m_Data->BlockReturned = false;
 
             // Exit
-            s_Data.Symbols.PopScope();
-            s_Data.LoopStack.pop_back();
-            s_Data.Builder->SetInsertPoint(exitBlock);
+            m_Data->LoopStack.pop_back();
+            m_Data->Builder->SetInsertPoint(exitBlock);
         }
 
         void LLVMVisitor::Visit(WhileLoop& node) {
-            llvm::Function* func = s_Data.Builder->GetInsertBlock()->getParent();
+            llvm::Function* func = m_Data->Builder->GetInsertBlock()->getParent();
 
-            llvm::BasicBlock* headerBlock = llvm::BasicBlock::Create(s_Data.Context, "loop.header", func);
-            llvm::BasicBlock* bodyBlock = llvm::BasicBlock::Create(s_Data.Context, "loop.body", func);
-            llvm::BasicBlock* exitBlock = llvm::BasicBlock::Create(s_Data.Context, "loop.exit", func);
-            s_Data.LoopStack.push_back({ headerBlock, exitBlock });
+            llvm::BasicBlock* headerBlock = llvm::BasicBlock::Create(m_Data->Context, "loop.header", func);
+            llvm::BasicBlock* bodyBlock = llvm::BasicBlock::Create(m_Data->Context, "loop.body", func);
+            llvm::BasicBlock* exitBlock = llvm::BasicBlock::Create(m_Data->Context, "loop.exit", func);
+            m_Data->LoopStack.push_back({ headerBlock, exitBlock });
 
-            s_Data.Symbols.PushScope();
-            s_Data.Builder->CreateBr(headerBlock);
+            m_Data->Builder->CreateBr(headerBlock);
 
             // Header block
-            s_Data.Builder->SetInsertPoint(headerBlock);
+            m_Data->Builder->SetInsertPoint(headerBlock);
             node.Condition->Accept(*this);
-            s_Data.Builder->CreateCondBr(s_Data.RetValue, bodyBlock, exitBlock);
+            m_Data->Builder->CreateCondBr(m_Data->RetValue, bodyBlock, exitBlock);
 
             // Body block
-            s_Data.Builder->SetInsertPoint(bodyBlock);
+            m_Data->Builder->SetInsertPoint(bodyBlock);
             node.CodeBlock->Accept(*this);
-            if (!s_Data.BlockReturned) {
-                s_Data.Builder->CreateBr(headerBlock);
+            if (!m_Data->BlockReturned) {
+                m_Data->Builder->CreateBr(headerBlock);
             }
-            s_Data.BlockReturned = false;
+            m_Data->BlockReturned = false;
 
             // Exit
-            s_Data.Symbols.PopScope();
-            s_Data.LoopStack.pop_back();
-            s_Data.Builder->SetInsertPoint(exitBlock);
+            m_Data->LoopStack.pop_back();
+            m_Data->Builder->SetInsertPoint(exitBlock);
         }
 
         void LLVMVisitor::Visit(Block& node) {
             for (auto& item : node.Items) {
                 item->Accept(*this);
-                if (s_Data.BlockReturned) {
+                if (m_Data->BlockReturned) {
                     return;
                 }
             }
         }
 
         void LLVMVisitor::Visit(Continue& node) {
-            s_Data.Builder->CreateBr(s_Data.LoopStack.back().Header);
-            s_Data.BlockReturned = true;
+            m_Data->Builder->CreateBr(m_Data->LoopStack.back().Header);
+            m_Data->BlockReturned = true;
         }
 
         void LLVMVisitor::Visit(Break& node) {
-            s_Data.Builder->CreateBr(s_Data.LoopStack.back().Exit);
-            s_Data.BlockReturned = true;
+            m_Data->Builder->CreateBr(m_Data->LoopStack.back().Exit);
+            m_Data->BlockReturned = true;
         }
 
         void LLVMVisitor::Visit(Return& node) {
-            node.Value->Accept(*this);
-            s_Data.Builder->CreateRet(s_Data.RetValue);
-            s_Data.BlockReturned = true;
+            if (node.Value) {
+                node.Value->Accept(*this);
+                m_Data->Builder->CreateRet(m_Data->RetValue);
+            }
+            else {
+                m_Data->Builder->CreateRetVoid();
+            }
+            m_Data->BlockReturned = true;
         }
 
         ///////////////////////////////////////////////////////////////////////
@@ -452,33 +621,35 @@ namespace scar {
         // EXPRESSIONS
 
         void LLVMVisitor::Visit(FunctionCall& node) {
-            llvm::Function* func = s_Data.Module->getFunction(node.Name.GetString());
+            llvm::Function* func = m_Data->Module->getFunction(node.Name.GetString());
             if (!func) {
-                SPAN_ERROR(FMT("undeclared funcation call: {}", node.Name), node.GetSpan());
+                SPAN_ERROR(node.GetSpan(), DiagID::UndeclaredFunction, node.Name);
+                m_Data->RetValue = nullptr;
                 return;
             }
 
             if (func->arg_size() != node.Args.size()) {
-                SPAN_ERROR(FMT("incorrect number of arguments: {}", node.Name), node.GetSpan());
+                SPAN_ERROR(node.GetSpan(), DiagID::ArgumentCountMismatch, node.Name);
+                m_Data->RetValue = nullptr;
                 return;
             }
 
             std::vector<llvm::Value*> argValues;
             for (size_t i = 0; i < node.Args.size(); i++) {
                 node.Args[i]->Accept(*this);
-                argValues.push_back(s_Data.RetValue);
-                if (!s_Data.RetValue) {
+                argValues.push_back(m_Data->RetValue);
+                if (!m_Data->RetValue) {
                     return;
                 }
             }
 
-            s_Data.RetValue = s_Data.Builder->CreateCall(func, argValues, "call");
+            m_Data->RetValue = m_Data->Builder->CreateCall(func, argValues, "call");
         }
 
         void LLVMVisitor::Visit(VarAccess& node) {
-            auto symbol = s_Data.Symbols.Find(node.Name);
-            s_Data.RetAlloca = symbol.Alloca;
-            s_Data.RetValue = s_Data.Builder->CreateLoad(symbol.Type, symbol.Alloca, node.Name.GetString());
+            const LLVMVisitorSymbol& symbol = FindSymbol(*m_Data, node.Name);
+            m_Data->RetAlloca = symbol.Alloca;
+            m_Data->RetValue = m_Data->Builder->CreateLoad(symbol.Type, symbol.Alloca, node.Name.GetString());
         }
 
         ///////////////////////////////////////////////////////////////////////
@@ -498,29 +669,29 @@ namespace scar {
                 break;
             case PrefixOperator::Minus:
                 node.RHS->Accept(*this);
-                s_Data.RetValue = s_Data.Builder->CreateFNeg(s_Data.RetValue, "fneg");
+                m_Data->RetValue = m_Data->Builder->CreateFNeg(m_Data->RetValue, "fneg");
                 break;
             case PrefixOperator::Not:
                 node.RHS->Accept(*this);
-                s_Data.RetValue = s_Data.Builder->CreateFCmpUNE(s_Data.RetValue, llvm::ConstantFP::get(s_Data.Context, llvm::APFloat(0.0)), "fcmpone");
-                s_Data.RetValue = s_Data.Builder->CreateNot(s_Data.RetValue, "not");
-                s_Data.RetValue = s_Data.Builder->CreateUIToFP(s_Data.RetValue, llvm::Type::getDoubleTy(s_Data.Context), "fbool");
+                m_Data->RetValue = m_Data->Builder->CreateFCmpUNE(m_Data->RetValue, llvm::ConstantFP::get(m_Data->Context, llvm::APFloat(0.0)), "fcmpone");
+                m_Data->RetValue = m_Data->Builder->CreateNot(m_Data->RetValue, "not");
+                m_Data->RetValue = m_Data->Builder->CreateUIToFP(m_Data->RetValue, llvm::Type::getDoubleTy(m_Data->Context), "fbool");
                 break;
             case PrefixOperator::BitNot:
                 node.RHS->Accept(*this);
-                s_Data.RetValue = s_Data.Builder->CreateNot(s_Data.RetValue, "bitnot");
+                m_Data->RetValue = m_Data->Builder->CreateNot(m_Data->RetValue, "bitnot");
                 break;
 
             default:
                 SCAR_BUG("missing LLVM IR code for prefix operator {}", (int)node.Type);
-                s_Data.RetValue = nullptr;
+                m_Data->RetValue = nullptr;
                 break;
             }
         }
 
         void LLVMVisitor::Visit(SuffixOperator& node) {
             node.LHS->Accept(*this);
-            llvm::Value* lhs = s_Data.RetValue;
+            llvm::Value* lhs = m_Data->RetValue;
 
             switch (node.Type) {
             case SuffixOperator::Increment:
@@ -535,25 +706,25 @@ namespace scar {
                 if (node.ResultType.IsBool()) {
                     if (node.LHS->ResultType.IsInt()) {
                         // Compare lhs to (i32) zero
-                        s_Data.RetValue = s_Data.Builder->CreateICmpNE(lhs, llvm::ConstantInt::get(llvm::Type::getInt32Ty(s_Data.Context), llvm::APInt(32, 0)), "cast");
+                        m_Data->RetValue = m_Data->Builder->CreateICmpNE(lhs, llvm::ConstantInt::get(llvm::Type::getInt32Ty(m_Data->Context), llvm::APInt(32, 0)), "cast");
                     }
                     else if (node.LHS->ResultType.IsFloat()) {
                         // Compare lhs to (f32) zero
-                        s_Data.RetValue = s_Data.Builder->CreateFCmpUNE(lhs, llvm::ConstantFP::get(llvm::Type::getFloatTy(s_Data.Context), llvm::APFloat(0.0f)), "cast");
+                        m_Data->RetValue = m_Data->Builder->CreateFCmpUNE(lhs, llvm::ConstantFP::get(llvm::Type::getFloatTy(m_Data->Context), llvm::APFloat(0.0f)), "cast");
                     }
                 }
                 // Cast to sint or uint
                 else if (node.ResultType.IsInt()) {
                     if (node.LHS->ResultType.IsBool() || node.LHS->ResultType.IsInt()) {
                         // Basic int cast
-                        s_Data.RetValue = s_Data.Builder->CreateIntCast(lhs, LLVMType(node.ResultType), node.ResultType.IsSInt(), "cast");
+                        m_Data->RetValue = m_Data->Builder->CreateIntCast(lhs, LLVMType(m_Data->Context, node.ResultType), node.ResultType.IsSInt(), "cast");
                     }
                     else if (node.LHS->ResultType.IsFloat()) {
                         // Convert from floating to sint/uint
                         if (node.ResultType.IsSInt())
-                            s_Data.RetValue = s_Data.Builder->CreateFPToSI(lhs, LLVMType(node.ResultType), "cast");
+                            m_Data->RetValue = m_Data->Builder->CreateFPToSI(lhs, LLVMType(m_Data->Context, node.ResultType), "cast");
                         else
-                            s_Data.RetValue = s_Data.Builder->CreateFPToUI(lhs, LLVMType(node.ResultType), "cast");
+                            m_Data->RetValue = m_Data->Builder->CreateFPToUI(lhs, LLVMType(m_Data->Context, node.ResultType), "cast");
                     }
                 }
                 // Cast to float
@@ -561,13 +732,13 @@ namespace scar {
                     if (node.LHS->ResultType.IsBool() || node.LHS->ResultType.IsInt()) {
                         // Convert from sint/uint to floating point
                         if (node.LHS->ResultType.IsUInt())
-                            s_Data.RetValue = s_Data.Builder->CreateUIToFP(lhs, LLVMType(node.ResultType), "cast");
+                            m_Data->RetValue = m_Data->Builder->CreateUIToFP(lhs, LLVMType(m_Data->Context, node.ResultType), "cast");
                         else
-                            s_Data.RetValue = s_Data.Builder->CreateSIToFP(lhs, LLVMType(node.ResultType), "cast");
+                            m_Data->RetValue = m_Data->Builder->CreateSIToFP(lhs, LLVMType(m_Data->Context, node.ResultType), "cast");
                     }
                     else if (node.LHS->ResultType.IsFloat()) {
                         // Basic floating point cast
-                        s_Data.RetValue = s_Data.Builder->CreateFPCast(lhs, LLVMType(node.ResultType), "cast");
+                        m_Data->RetValue = m_Data->Builder->CreateFPCast(lhs, LLVMType(m_Data->Context, node.ResultType), "cast");
                     }
                 }
                 // Cast to char
@@ -579,75 +750,76 @@ namespace scar {
                     SCAR_BUG("missing LLVM IR code for cast to string");
                 }
                 else {
-                    SPAN_ERROR("invalid cast", node.GetSpan());
+                    SPAN_ERROR(node.GetSpan(), DiagID::InvalidCast);
+                    m_Data->RetValue = nullptr;
                 }
                 break;
             }
 
             default:
                 SCAR_BUG("missing LLVM IR code for prefix operator {}", node.Type);
-                s_Data.RetValue = nullptr;
+                m_Data->RetValue = nullptr;
                 break;
             }
         }
 
-        void MakeBothFloat(llvm::Value*& lhs, llvm::Value*& rhs, const Ref<Expr>& lhsNode, const Ref<Expr>& rhsNode) {
+        static void MakeBothFloat(llvm::IRBuilder<>& builder, llvm::Value*& lhs, llvm::Value*& rhs, const Expr* lhsNode, const Expr* rhsNode) {
             if (lhs->getType()->isIntegerTy()) {
                 if (TypeIsSigned(lhsNode->ResultType))
-                    lhs = s_Data.Builder->CreateSIToFP(lhs, rhs->getType(), "sitofp");
-                else lhs = s_Data.Builder->CreateUIToFP(lhs, rhs->getType(), "uitofp");
+                    lhs = builder.CreateSIToFP(lhs, rhs->getType(), "sitofp");
+                else lhs = builder.CreateUIToFP(lhs, rhs->getType(), "uitofp");
             }
             if (rhs->getType()->isIntegerTy()) {
                 if (TypeIsSigned(rhsNode->ResultType))
-                    rhs = s_Data.Builder->CreateSIToFP(rhs, lhs->getType(), "sitofp");
-                else rhs = s_Data.Builder->CreateUIToFP(rhs, lhs->getType(), "uitofp");
+                    rhs = builder.CreateSIToFP(rhs, lhs->getType(), "sitofp");
+                else rhs = builder.CreateUIToFP(rhs, lhs->getType(), "uitofp");
             }
         }
 
-        llvm::Value* CreateMul(llvm::Value* lhs, llvm::Value* rhs, const Ref<Expr>& lhsNode, const Ref<Expr>& rhsNode) {
+        static llvm::Value* CreateMul(llvm::IRBuilder<>& builder, llvm::Value* lhs, llvm::Value* rhs, const Expr* lhsNode, const Expr* rhsNode) {
             if (lhs->getType()->isDoubleTy() || rhs->getType()->isDoubleTy()) {
-                MakeBothFloat(lhs, rhs, lhsNode, rhsNode);
-                return s_Data.Builder->CreateFMul(lhs, rhs, "fmul");
+                MakeBothFloat(builder, lhs, rhs, lhsNode, rhsNode);
+                return builder.CreateFMul(lhs, rhs, "fmul");
             }
-            return s_Data.Builder->CreateMul(lhs, rhs, "mul");
+            return builder.CreateMul(lhs, rhs, "mul");
         }
 
-        llvm::Value* CreateDiv(llvm::Value* lhs, llvm::Value* rhs, const Ref<Expr>& lhsNode, const Ref<Expr>& rhsNode) {
+        static llvm::Value* CreateDiv(llvm::IRBuilder<>& builder, llvm::Value* lhs, llvm::Value* rhs, const Expr* lhsNode, const Expr* rhsNode) {
             if (lhs->getType()->isDoubleTy() || rhs->getType()->isDoubleTy()) {
-                MakeBothFloat(lhs, rhs, lhsNode, rhsNode);
-                return s_Data.Builder->CreateFDiv(lhs, rhs, "fdiv");
+                MakeBothFloat(builder, lhs, rhs, lhsNode, rhsNode);
+                return builder.CreateFDiv(lhs, rhs, "fdiv");
             }
             if (TypeIsSigned(lhsNode->ResultType) || TypeIsSigned(lhsNode->ResultType)) {
-                return s_Data.Builder->CreateSDiv(lhs, rhs, "sdiv");
+                return builder.CreateSDiv(lhs, rhs, "sdiv");
             }
-            return s_Data.Builder->CreateUDiv(lhs, rhs, "udiv");
+            return builder.CreateUDiv(lhs, rhs, "udiv");
         }
 
-        llvm::Value* CreateRem(llvm::Value* lhs, llvm::Value* rhs, const Ref<Expr>& lhsNode, const Ref<Expr>& rhsNode) {
+        static llvm::Value* CreateRem(llvm::IRBuilder<>& builder, llvm::Value* lhs, llvm::Value* rhs, const Expr* lhsNode, const Expr* rhsNode) {
             if (lhs->getType()->isDoubleTy() || rhs->getType()->isDoubleTy()) {
-                MakeBothFloat(lhs, rhs, lhsNode, rhsNode);
-                return s_Data.Builder->CreateFRem(lhs, rhs, "frem");
+                MakeBothFloat(builder, lhs, rhs, lhsNode, rhsNode);
+                return builder.CreateFRem(lhs, rhs, "frem");
             }
             if (TypeIsSigned(lhsNode->ResultType) || TypeIsSigned(lhsNode->ResultType)) {
-                return s_Data.Builder->CreateSRem(lhs, rhs, "srem");
+                return builder.CreateSRem(lhs, rhs, "srem");
             }
-            return s_Data.Builder->CreateURem(lhs, rhs, "urem");
+            return builder.CreateURem(lhs, rhs, "urem");
         }
 
-        llvm::Value* CreateAdd(llvm::Value* lhs, llvm::Value* rhs, const Ref<Expr>& lhsNode, const Ref<Expr>& rhsNode) {
+        static llvm::Value* CreateAdd(llvm::IRBuilder<>& builder, llvm::Value* lhs, llvm::Value* rhs, const Expr* lhsNode, const Expr* rhsNode) {
             if (lhs->getType()->isDoubleTy() || rhs->getType()->isDoubleTy()) {
-                MakeBothFloat(lhs, rhs, lhsNode, rhsNode);
-                return s_Data.Builder->CreateFAdd(lhs, rhs, "fadd");
+                MakeBothFloat(builder, lhs, rhs, lhsNode, rhsNode);
+                return builder.CreateFAdd(lhs, rhs, "fadd");
             }
-            return s_Data.Builder->CreateAdd(lhs, rhs, "add");
+            return builder.CreateAdd(lhs, rhs, "add");
         }
 
-        llvm::Value* CreateSub(llvm::Value* lhs, llvm::Value* rhs, const Ref<Expr>& lhsNode, const Ref<Expr>& rhsNode) {
+        static llvm::Value* CreateSub(llvm::IRBuilder<>& builder, llvm::Value* lhs, llvm::Value* rhs, const Expr* lhsNode, const Expr* rhsNode) {
             if (lhs->getType()->isDoubleTy() || rhs->getType()->isDoubleTy()) {
-                MakeBothFloat(lhs, rhs, lhsNode, rhsNode);
-                return s_Data.Builder->CreateFSub(lhs, rhs, "fsub");
+                MakeBothFloat(builder, lhs, rhs, lhsNode, rhsNode);
+                return builder.CreateFSub(lhs, rhs, "fsub");
             }
-            return s_Data.Builder->CreateSub(lhs, rhs, "sub");
+            return builder.CreateSub(lhs, rhs, "sub");
         }
 
         void LLVMVisitor::Visit(BinaryOperator& node) {
@@ -656,14 +828,17 @@ namespace scar {
             case BinaryOperator::Assign: {
                 // Visit LHS
                 node.LHS->Accept(*this);
-                llvm::AllocaInst* alloc = s_Data.RetAlloca;
+                llvm::AllocaInst* alloc = m_Data->RetAlloca;
 
                 // Visit RHS
                 node.RHS->Accept(*this);
-                llvm::Value* val = s_Data.RetValue;
+                llvm::Value* val = m_Data->RetValue;
+                if (!val) {
+                    return;
+                }
 
-                s_Data.Builder->CreateStore(val, alloc);
-                s_Data.RetValue = val;
+                m_Data->Builder->CreateStore(val, alloc);
+                m_Data->RetValue = val;
                 return;
             }
             default: break;
@@ -672,12 +847,12 @@ namespace scar {
             // TODO: Add short-circuit evaluation for && and ||
 
             node.LHS->Accept(*this);
-            llvm::Value* lhs = s_Data.RetValue;
+            llvm::Value* lhs = m_Data->RetValue;
             node.RHS->Accept(*this);
-            llvm::Value* rhs = s_Data.RetValue;
+            llvm::Value* rhs = m_Data->RetValue;
 
             if (!lhs || !rhs) {
-                s_Data.RetValue = nullptr;
+                m_Data->RetValue = nullptr;
                 return;
             }
 
@@ -686,61 +861,61 @@ namespace scar {
                 SCAR_UNIMPL("BinaryOperator::MemberAccess");
                 break;
             case BinaryOperator::Multiply:
-                s_Data.RetValue = CreateMul(lhs, rhs, node.LHS, node.RHS);
+                m_Data->RetValue = CreateMul(*m_Data->Builder, lhs, rhs, node.LHS, node.RHS);
                 break;
             case BinaryOperator::Divide:
-                s_Data.RetValue = CreateDiv(lhs, rhs, node.LHS, node.RHS);
+                m_Data->RetValue = CreateDiv(*m_Data->Builder, lhs, rhs, node.LHS, node.RHS);
                 break;
             case BinaryOperator::Remainder:
-                s_Data.RetValue = CreateRem(lhs, rhs, node.LHS, node.RHS);
+                m_Data->RetValue = CreateRem(*m_Data->Builder, lhs, rhs, node.LHS, node.RHS);
                 break;
             case BinaryOperator::Plus:
-                s_Data.RetValue = CreateAdd(lhs, rhs, node.LHS, node.RHS);
+                m_Data->RetValue = CreateAdd(*m_Data->Builder, lhs, rhs, node.LHS, node.RHS);
                 break;
             case BinaryOperator::Minus:
-                s_Data.RetValue = CreateSub(lhs, rhs, node.LHS, node.RHS);
+                m_Data->RetValue = CreateSub(*m_Data->Builder, lhs, rhs, node.LHS, node.RHS);
                 break;
             case BinaryOperator::Greater:
-                s_Data.RetValue = s_Data.Builder->CreateFCmpUGT(lhs, rhs, "fgr");
+                m_Data->RetValue = m_Data->Builder->CreateFCmpUGT(lhs, rhs, "fgr");
                 break;
             case BinaryOperator::GreaterEq:
-                s_Data.RetValue = s_Data.Builder->CreateFCmpUGE(lhs, rhs, "fgeq");
+                m_Data->RetValue = m_Data->Builder->CreateFCmpUGE(lhs, rhs, "fgeq");
                 break;
             case BinaryOperator::Lesser:
-                s_Data.RetValue = s_Data.Builder->CreateFCmpULT(lhs, rhs, "fle");
+                m_Data->RetValue = m_Data->Builder->CreateFCmpULT(lhs, rhs, "fle");
                 break;
             case BinaryOperator::LesserEq:
-                s_Data.RetValue = s_Data.Builder->CreateFCmpULE(lhs, rhs, "fleq");
+                m_Data->RetValue = m_Data->Builder->CreateFCmpULE(lhs, rhs, "fleq");
                 break;
             case BinaryOperator::Eq:
-                s_Data.RetValue = s_Data.Builder->CreateFCmpUEQ(lhs, rhs, "feq");
+                m_Data->RetValue = m_Data->Builder->CreateFCmpUEQ(lhs, rhs, "feq");
                 break;
             case BinaryOperator::NotEq:
-                s_Data.RetValue = s_Data.Builder->CreateFCmpUNE(lhs, rhs, "fneq");
+                m_Data->RetValue = m_Data->Builder->CreateFCmpUNE(lhs, rhs, "fneq");
                 break;
             case BinaryOperator::BitAnd:
-                s_Data.RetValue = s_Data.Builder->CreateAnd(lhs, rhs, "band");
+                m_Data->RetValue = m_Data->Builder->CreateAnd(lhs, rhs, "band");
                 break;
             case BinaryOperator::BitXOr:
-                s_Data.RetValue = s_Data.Builder->CreateXor(lhs, rhs, "bxor");
+                m_Data->RetValue = m_Data->Builder->CreateXor(lhs, rhs, "bxor");
                 break;
             case BinaryOperator::BitOr:
-                s_Data.RetValue = s_Data.Builder->CreateOr(lhs, rhs, "bor");
+                m_Data->RetValue = m_Data->Builder->CreateOr(lhs, rhs, "bor");
                 break;
             case BinaryOperator::LogicAnd:
-                lhs = s_Data.Builder->CreateFCmpONE(lhs, llvm::ConstantFP::get(s_Data.Context, llvm::APFloat(0.0)), "lhs.neq");
-                rhs = s_Data.Builder->CreateFCmpONE(rhs, llvm::ConstantFP::get(s_Data.Context, llvm::APFloat(0.0)), "rhs.neq");
-                s_Data.RetValue = s_Data.Builder->CreateAnd(lhs, rhs, "and");
+                lhs = m_Data->Builder->CreateFCmpONE(lhs, llvm::ConstantFP::get(m_Data->Context, llvm::APFloat(0.0)), "lhs.neq");
+                rhs = m_Data->Builder->CreateFCmpONE(rhs, llvm::ConstantFP::get(m_Data->Context, llvm::APFloat(0.0)), "rhs.neq");
+                m_Data->RetValue = m_Data->Builder->CreateAnd(lhs, rhs, "and");
                 break;
             case BinaryOperator::LogicOr:
-                lhs = s_Data.Builder->CreateFCmpONE(lhs, llvm::ConstantFP::get(s_Data.Context, llvm::APFloat(0.0)), "lhs.neq");
-                rhs = s_Data.Builder->CreateFCmpONE(rhs, llvm::ConstantFP::get(s_Data.Context, llvm::APFloat(0.0)), "rhs.neq");
-                s_Data.RetValue = s_Data.Builder->CreateOr(lhs, rhs, "or");
+                lhs = m_Data->Builder->CreateFCmpONE(lhs, llvm::ConstantFP::get(m_Data->Context, llvm::APFloat(0.0)), "lhs.neq");
+                rhs = m_Data->Builder->CreateFCmpONE(rhs, llvm::ConstantFP::get(m_Data->Context, llvm::APFloat(0.0)), "rhs.neq");
+                m_Data->RetValue = m_Data->Builder->CreateOr(lhs, rhs, "or");
                 break;
 
             default:
                 SCAR_BUG("missing LLVM IR code for binary operator {}", node.Type);
-                s_Data.RetValue = nullptr;
+                m_Data->RetValue = nullptr;
                 break;
             }
         }
@@ -750,25 +925,25 @@ namespace scar {
         // LITERALS
 
         void LLVMVisitor::Visit(LiteralBool& node) {
-            llvm::Type* type = LLVMType(node.ResultType);
+            llvm::Type* type = LLVMType(m_Data->Context, node.ResultType);
             unsigned int bits = TypeBits(node.ResultType);
-            s_Data.RetValue = llvm::ConstantInt::get(type, llvm::APInt(bits, node.Value));
+            m_Data->RetValue = llvm::ConstantInt::get(type, llvm::APInt(bits, node.Value));
         }
 
         void LLVMVisitor::Visit(LiteralInteger& node) {
-            llvm::Type* type = LLVMType(node.ResultType);
+            llvm::Type* type = LLVMType(m_Data->Context, node.ResultType);
             unsigned int bits = TypeBits(node.ResultType);
             bool sign = TypeIsSigned(node.ResultType);
-            s_Data.RetValue = llvm::ConstantInt::get(type, llvm::APInt(bits, node.Value, sign));
+            m_Data->RetValue = llvm::ConstantInt::get(type, llvm::APInt(bits, node.Value, sign));
         }
 
         void LLVMVisitor::Visit(LiteralFloat& node) {
-            llvm::Type* type = LLVMType(node.ResultType);
-            s_Data.RetValue = llvm::ConstantFP::get(type, llvm::APFloat(node.Value));
+            llvm::Type* type = LLVMType(m_Data->Context, node.ResultType);
+            m_Data->RetValue = llvm::ConstantFP::get(type, llvm::APFloat(node.Value));
         }
 
         void LLVMVisitor::Visit(LiteralString& node) {
-            s_Data.RetValue = nullptr;
+            m_Data->RetValue = nullptr;
         }
 
     }
@@ -2,11 +2,19 @@
 #include "Parse/AST/AST.hpp"
 
 namespace scar {
+
+    class DiagnosticEngine;
+
     namespace ast {
 
+        struct LLVMVisitorData;
+
+        // Generates the LLVM IR of a verified Module. With -fparallel-codegen the functions are split
+        // into one partition per thread, each generated in its own LLVMContext and linked back together.
         class LLVMVisitor : public Visitor {
         public:
-            LLVMVisitor();
+            explicit LLVMVisitor(DiagnosticEngine& diagnostics);
+            ~LLVMVisitor();
 
             void Print() const;
 
@@ -36,6 +44,15 @@ namespace scar {
             void Visit(LiteralInteger& node) override;
             void Visit(LiteralFloat& node) override;
             void Visit(LiteralString& node) override;
+
+        private:
+            DiagnosticEngine& m_Diagnostics;
+            Scope<LLVMVisitorData> m_Data;
+
+            void DeclareFunctions(Module& node);
+            bool GenerateParallel(Module& node, const std::vector<Function*>& functions);
+            // Runs the -O pipeline on the whole module
+            void Optimize();
         };
 
     }
@@ -66,7 +66,10 @@ namespace scar {
             PRINT_AND_SCOPE("Function");
             node.Prototype->Accept(*this);
             EnableBranch(false);
-            node.CodeBlock->Accept(*this);
+            // Bodies nothing called were never parsed
+            if (node.IsBodyParsed()) {
+                node.GetCodeBlock()->Accept(*this);
+            }
         }
 
         void PrintVisitor::Visit(FunctionPrototype& node) {
@@ -102,9 +105,13 @@ namespace scar {
 
         void PrintVisitor::Visit(ForLoop& node) {
             PRINT_AND_SCOPE("ForLoop");
-            node.Init->Accept(*this);
+            if (node.Init) {
+                node.Init->Accept(*this);
+            }
             node.Condition->Accept(*this);
-            node.Update->Accept(*this);
+            if (node.Update) {
+                node.Update->Accept(*this);
+            }
             EnableBranch(false);
             node.CodeBlock->Accept(*this);
         }
@@ -135,7 +142,9 @@ namespace scar {
         void PrintVisitor::Visit(Return& node) {
             PRINT_AND_SCOPE("Return");
             EnableBranch(false);
-            node.Value->Accept(*this);
+            if (node.Value) {
+                node.Value->Accept(*this);
+            }
         }
 
         ///////////////////////////////////////////////////////////////////////
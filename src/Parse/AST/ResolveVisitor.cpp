@@ -0,0 +1,209 @@
+#include "scarpch.hpp"
+#include "Parse/AST/ResolveVisitor.hpp"
+
+namespace scar {
+    namespace ast {
+
+        ///////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////////////////////////////////
+        // VISITOR
+
+        void ResolveVisitor::Declare(Ident& name) {
+            name.Symbol = m_NextSymbol++;
+            m_Symbols.Add(name);
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////////////////////////////////
+        // TYPE
+
+        void ResolveVisitor::Visit(Type& node) {
+
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////////////////////////////////
+        // DECLARATIONS
+
+        void ResolveVisitor::Visit(Module& node) {
+            m_NextSymbol = 0;
+
+            // Every function can be called from anywhere in the module, declare them all first.
+            // They get the first SymbolIDs, in the order of the items.
+            m_Declarations.clear();
+            bool hasMain = false;
+            for (auto& item : node.Items) {
+                if (auto function = dynamic_cast<Function*>(item)) {
+                    Declare(function->Prototype->Name);
+                    hasMain |= function->Prototype->Name.GetString() == "main";
+                }
+                else if (auto prototype = dynamic_cast<FunctionPrototype*>(item)) {
+                    Declare(prototype->Name);
+                }
+                m_Declarations.push_back(item);
+            }
+
+            // Bodies that are already parsed are always resolved, skipped ones start from main.
+            // Without a main function every function is an entry point.
+            m_Reached.assign(m_Declarations.size(), true);
+            for (size_t i = 0; i < m_Declarations.size(); i++) {
+                if (auto function = dynamic_cast<Function*>(m_Declarations[i])) {
+                    m_Reached[i] = !hasMain || function->IsBodyParsed() || function->Prototype->Name.GetString() == "main";
+                }
+            }
+
+            // Sweep the items until no new body is reached, keeping SymbolIDs in item order where possible.
+            // With every body parsed up front this is a single pass.
+            std::vector<bool> resolved(m_Declarations.size(), false);
+            for (bool progress = true; progress;) {
+                progress = false;
+                for (size_t i = 0; i < m_Declarations.size(); i++) {
+                    if (m_Reached[i] && !resolved[i]) {
+                        m_Declarations[i]->Accept(*this);
+                        resolved[i] = true;
+                        progress = true;
+                    }
+                }
+            }
+
+            // The arguments of the unreached functions still need SymbolIDs for their prototypes to be checked
+            for (size_t i = 0; i < m_Declarations.size(); i++) {
+                if (!resolved[i]) {
+                    static_cast<Function*>(m_Declarations[i])->Prototype->Accept(*this);
+                }
+            }
+            node.SymbolCount = m_NextSymbol;
+        }
+
+        void ResolveVisitor::Visit(Function& node) {
+            m_Symbols.PushScope();
+            node.Prototype->Accept(*this);
+            for (auto& arg : node.Prototype->Args) {
+                m_Symbols.Add(arg.Name);
+            }
+            node.GetCodeBlock()->Accept(*this);
+            m_Symbols.PopScope();
+        }
+
+        void ResolveVisitor::Visit(FunctionPrototype& node) {
+            // The name was declared with the module, the arguments are only in scope in the function's body
+            for (auto& arg : node.Args) {
+                arg.Name.Symbol = m_NextSymbol++;
+            }
+        }
+
+        void ResolveVisitor::Visit(VarDecl& node) {
+            Declare(node.Name);
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////////////////////////////////
+        // STATEMENTS
+
+        void ResolveVisitor::Visit(Branch& node) {
+            node.Condition->Accept(*this);
+            node.TrueBlock->Accept(*this);
+            node.FalseBlock->Accept(*this);
+        }
+
+        void ResolveVisitor::Visit(ForLoop& node) {
+            // Variables declared by Init only live as long as the loop
+            m_Symbols.PushScope();
+            if (node.Init) {
+                node.Init->Accept(*this);
+            }
+            node.Condition->Accept(*this);
+            if (node.Update) {
+                node.Update->Accept(*this);
+            }
+            node.CodeBlock->Accept(*this);
+            m_Symbols.PopScope();
+        }
+
+        void ResolveVisitor::Visit(WhileLoop& node) {
+            m_Symbols.PushScope();
+            node.Condition->Accept(*this);
+            node.CodeBlock->Accept(*this);
+            m_Symbols.PopScope();
+        }
+
+        void ResolveVisitor::Visit(Block& node) {
+            m_Symbols.PushScope();
+            for (auto& item : node.Items) {
+                item->Accept(*this);
+            }
+            m_Symbols.PopScope();
+        }
+
+        void ResolveVisitor::Visit(Continue& node) {
+
+        }
+
+        void ResolveVisitor::Visit(Break& node) {
+
+        }
+
+        void ResolveVisitor::Visit(Return& node) {
+            if (node.Value) {
+                node.Value->Accept(*this);
+            }
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////////////////////////////////
+        // EXPRESSIONS
+
+        void ResolveVisitor::Visit(FunctionCall& node) {
+            node.Name.Symbol = m_Symbols.Find(node.Name);
+            // Module items have the first SymbolIDs, a local variable shadowing the name has a later one
+            if (node.Name.Symbol < m_Reached.size()) {
+                m_Reached[node.Name.Symbol] = true;
+            }
+            for (auto& arg : node.Args) {
+                arg->Accept(*this);
+            }
+        }
+
+        void ResolveVisitor::Visit(VarAccess& node) {
+            node.Name.Symbol = m_Symbols.Find(node.Name);
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////////////////////////////////
+        // OPERATORS
+
+        void ResolveVisitor::Visit(PrefixOperator& node) {
+            node.RHS->Accept(*this);
+        }
+
+        void ResolveVisitor::Visit(SuffixOperator& node) {
+            node.LHS->Accept(*this);
+        }
+
+        void ResolveVisitor::Visit(BinaryOperator& node) {
+            node.LHS->Accept(*this);
+            node.RHS->Accept(*this);
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        ///////////////////////////////////////////////////////////////////////
+        // LITERALS
+
+        void ResolveVisitor::Visit(LiteralBool& node) {
+
+        }
+
+        void ResolveVisitor::Visit(LiteralInteger& node) {
+
+        }
+
+        void ResolveVisitor::Visit(LiteralFloat& node) {
+
+        }
+
+        void ResolveVisitor::Visit(LiteralString& node) {
+
+        }
+
+    }
+}
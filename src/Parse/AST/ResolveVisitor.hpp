@@ -0,0 +1,70 @@
+#pragma once
+#include "Parse/AST/AST.hpp"
+#include "Parse/AST/SymbolTable.hpp"
+
+namespace scar {
+    namespace ast {
+
+        class ResolveVisitorSymbolTable : public SymbolTable<SymbolID> {
+        public:
+            ResolveVisitorSymbolTable() = default;
+            ~ResolveVisitorSymbolTable() = default;
+
+            void Add(const Ident& key) { Bind(key.StringID, key.Symbol); }
+
+            SymbolID Find(const Ident& key) const {
+                auto ret = TryFind(key.StringID);
+                if (!ret) return NoSymbol;
+                return *ret;
+            }
+        };
+
+        // Binds every name to its declaration once, so later passes don't look names up themselves.
+        // Each declaration gets a new SymbolID and every use is given the SymbolID it refers to,
+        // names without a declaration in scope are left as NoSymbol for the passes to report.
+        // A skipped function body is only parsed and resolved once a resolved body calls the function,
+        // bodies that are never reached stay unparsed and the later passes leave them out.
+        class ResolveVisitor : public Visitor {
+        public:
+            ResolveVisitor() = default;
+
+            void Visit(Type& node) override;
+
+            void Visit(Module& node) override;
+            void Visit(Function& node) override;
+            void Visit(FunctionPrototype& node) override;
+            void Visit(VarDecl& node) override;
+
+            void Visit(Branch& node) override;
+            void Visit(ForLoop& node) override;
+            void Visit(WhileLoop& node) override;
+            void Visit(Block& node) override;
+            void Visit(Continue& node) override;
+            void Visit(Break& node) override;
+            void Visit(Return& node) override;
+
+            void Visit(FunctionCall& node) override;
+            void Visit(VarAccess& node) override;
+
+            void Visit(PrefixOperator& node) override;
+            void Visit(SuffixOperator& node) override;
+            void Visit(BinaryOperator& node) override;
+
+            void Visit(LiteralBool& node) override;
+            void Visit(LiteralInteger& node) override;
+            void Visit(LiteralFloat& node) override;
+            void Visit(LiteralString& node) override;
+
+        private:
+            ResolveVisitorSymbolTable m_Symbols;
+            SymbolID m_NextSymbol = 0;
+            // Module items by their SymbolID, and whether a resolved body has called them
+            std::vector<Stmt*> m_Declarations;
+            std::vector<bool> m_Reached;
+
+            // Give name a new SymbolID and bind it in the current scope
+            void Declare(Ident& name);
+        };
+
+    }
+}
@@ -1,29 +1,71 @@
 #pragma once
+#include "Parse/Interner.hpp"
 
 namespace scar {
     namespace ast {
 
-        template<typename Key, typename Value>
+        // Scoped map from interned names to values.
+        // Every StringID has a slot holding its innermost binding, so lookups are a single index.
+        // Bindings that get shadowed are saved in an undo log and put back when their scope is popped,
+        // popping a scope only touches the names bound in it.
+        template<typename Value>
         class SymbolTable {
         public:
             SymbolTable() { PushScope(); }
-            virtual ~SymbolTable() = default;
 
-            virtual void PushScope() { m_Symbols.push_back({}); }
-            virtual void PopScope()  { m_Symbols.pop_back(); }
+            void PushScope() { m_ScopeStarts.push_back((uint32_t)m_UndoLog.size()); }
+            void PopScope() {
+                uint32_t start = m_ScopeStarts.back();
+                m_ScopeStarts.pop_back();
+
+                // Restore the shadowed bindings, most recent first
+                while (m_UndoLog.size() > start) {
+                    Shadowed& shadowed = m_UndoLog.back();
+                    m_Bindings[shadowed.ID] = shadowed.Previous;
+                    m_UndoLog.pop_back();
+                }
+            }
 
         protected:
-            std::vector<std::unordered_map<Key, Value>> m_Symbols;
-
-            virtual const Value* TryFind(const Key& key) const {
-                for (auto iter = m_Symbols.rbegin(); iter != m_Symbols.rend(); iter++) {
-                    auto item = iter->find(key);
-                    if (item != iter->end()) {
-                        return &item->second;
-                    }
+            // Bind a name in the innermost scope, replacing its binding if it's from the same scope
+            void Bind(Interner::StringID id, const Value& value) {
+                if (id >= m_Bindings.size()) {
+                    // Every name interned so far is likely to be bound at some point
+                    m_Bindings.resize(std::max<size_t>(id + 1, Interner::GetCount()));
+                }
+
+                Binding& binding = m_Bindings[id];
+                uint32_t depth = (uint32_t)m_ScopeStarts.size();
+                if (binding.Depth != depth) {
+                    m_UndoLog.push_back({ id, binding });
                 }
-                return nullptr;
+                binding.Data = value;
+                binding.Depth = depth;
             }
+
+            const Value* TryFind(Interner::StringID id) const {
+                if (id >= m_Bindings.size() || m_Bindings[id].Depth == 0) {
+                    return nullptr;
+                }
+                return &m_Bindings[id].Data;
+            }
+
+        private:
+            struct Binding {
+                Value Data{};
+                // Number of scopes open when it was bound, zero if it's unbound
+                uint32_t Depth = 0;
+            };
+            struct Shadowed {
+                Interner::StringID ID;
+                Binding Previous;
+            };
+
+            // Indexed by StringID
+            std::vector<Binding> m_Bindings;
+            std::vector<Shadowed> m_UndoLog;
+            // Start of each open scope in the undo log
+            std::vector<uint32_t> m_ScopeStarts;
         };
 
     }
@@ -1,8 +1,8 @@
 #include "scarpch.hpp"
 #include "Parse/AST/VerifyVisitor.hpp"
-#include "Parse/AST/SymbolTable.hpp"
+#include "Core/ThreadPool.hpp"
 
-#define SPAN_ERROR(msg, span) SCAR_ERROR("{}: {}", span, msg)
+#define SPAN_ERROR(span, ...) m_Diagnostics.Report(span, __VA_ARGS__)
 
 namespace scar {
     namespace ast {
@@ -38,29 +38,43 @@ namespace scar {
         ///////////////////////////////////////////////////////////////////////
         // VISITOR
 
-        class VerifyVisitorSymbolTable : public SymbolTable<std::string, TypeInfo> {
-        public:
-            VerifyVisitorSymbolTable() = default;
-            ~VerifyVisitorSymbolTable() = default;
+        VerifyVisitor::VerifyVisitor(DiagnosticEngine& diagnostics) :
+            m_Diagnostics(diagnostics), m_SymbolTypes(&m_ModuleSymbolTypes) {}
 
-            void Add(const Ident& key, TypeInfo value) { Add(key.GetString(), value); }
-            void Add(const std::string& key, TypeInfo value) {
-                m_Symbols.back()[key] = value;
-            }
+        VerifyVisitor::VerifyVisitor(VerifyVisitor& parent, DiagnosticEngine& diagnostics) :
+            m_Diagnostics(diagnostics), m_SymbolTypes(parent.m_SymbolTypes) {}
+
+        // Invalid for names the ResolveVisitor couldn't bind
+        TypeInfo VerifyVisitor::SymbolType(const Ident& name) const {
+            if (name.Symbol == NoSymbol) return TypeInfo::Invalid;
+            return (*m_SymbolTypes)[name.Symbol];
+        }
 
-            TypeInfo Find(const Ident& key) const { return Find(key.GetString()); }
-            TypeInfo Find(const std::string& key) const {
-                auto ret = TryFind(key);
-                if (!ret) return TypeInfo::Invalid;
-                return *ret;
+        void VerifyVisitor::VerifyBodies(const std::vector<Function*>& functions) {
+            if (!Session::GetProperties().ParallelVerify || functions.size() <= 1 || Session::GetThreadPool().GetThreadCount() <= 1) {
+                for (Function* function : functions) {
+                    function->Accept(*this);
+                }
+                return;
             }
-        };
 
-        struct VerifyVisitorData {
-            VerifyVisitorSymbolTable Symbols;
-            FunctionPrototype* CurrentFunction;
-        };
-        static VerifyVisitorData s_Data;
+            // A few batches per thread keeps the threads busy when function sizes vary
+            ThreadPool& pool = Session::GetThreadPool();
+            size_t batchCount = std::min(functions.size(), pool.GetThreadCount() * 4);
+            std::vector<DiagnosticEngine> diagnostics(batchCount);
+            pool.ParallelFor(batchCount, [&](size_t i) {
+                VerifyVisitor verify(*this, diagnostics[i]);
+                size_t end = functions.size() * (i + 1) / batchCount;
+                for (size_t j = functions.size() * i / batchCount; j < end; j++) {
+                    functions[j]->Accept(verify);
+                }
+            });
+
+            // Batches are contiguous, appending them in order keeps the diagnostics in source order
+            for (DiagnosticEngine& batch : diagnostics) {
+                m_Diagnostics.Append(batch);
+            }
+        }
 
         ///////////////////////////////////////////////////////////////////////
         ///////////////////////////////////////////////////////////////////////
@@ -75,36 +89,46 @@ namespace scar {
         // DECLARATIONS
 
         void VerifyVisitor::Visit(Module& node) {
+            m_SymbolTypes->assign(node.SymbolCount, TypeInfo::Invalid);
+
+            // Prototypes first, a body only needs them and its own declarations.
+            // Bodies the ResolveVisitor never reached are left unparsed, only their prototypes are checked.
+            std::vector<Function*> functions;
             for (auto& item : node.Items) {
-                item->Accept(*this);
+                if (auto function = dynamic_cast<Function*>(item)) {
+                    function->Prototype->Accept(*this);
+                    if (function->IsBodyParsed()) {
+                        functions.push_back(function);
+                    }
+                }
+                else {
+                    item->Accept(*this);
+                }
             }
+
+            VerifyBodies(functions);
         }
 
+        // The prototype was checked with the Module
         void VerifyVisitor::Visit(Function& node) {
-            s_Data.Symbols.PushScope();
-            node.Prototype->Accept(*this);
-
-            s_Data.CurrentFunction = node.Prototype.get();
-            node.CodeBlock->Accept(*this);
-            s_Data.CurrentFunction = nullptr;
-
-            s_Data.Symbols.PopScope();
+            m_CurrentFunction = node.Prototype;
+            node.GetCodeBlock()->Accept(*this);
+            m_CurrentFunction = nullptr;
         }
 
         void VerifyVisitor::Visit(FunctionPrototype& node) {
-            TypeInfo type = node.ReturnType->ResultType;
-            s_Data.Symbols.Add(node.Name, type);
+            (*m_SymbolTypes)[node.Name.Symbol] = node.ReturnType->ResultType;
 
             for (auto& arg : node.Args) {
-                s_Data.Symbols.Add(arg.Name, arg.VarType->ResultType);
+                (*m_SymbolTypes)[arg.Name.Symbol] = arg.VarType->ResultType;
             }
         }
 
         void VerifyVisitor::Visit(VarDecl& node) {
             node.VarType->Accept(*this);
             if (node.ResultType.IsVoid())
-                SPAN_ERROR("invalid void type variable", node.VarType->GetSpan());
-            s_Data.Symbols.Add(node.Name, node.ResultType);
+                SPAN_ERROR(node.VarType->GetSpan(), DiagID::VoidVariable);
+            (*m_SymbolTypes)[node.Name.Symbol] = node.ResultType;
         }
 
         ///////////////////////////////////////////////////////////////////////
@@ -116,34 +140,40 @@ namespace scar {
             node.TrueBlock->Accept(*this);
             node.FalseBlock->Accept(*this);
 
-            if (!node.Condition->ResultType.IsBool())
-                SPAN_ERROR(FMT("expectead a boolean, found {}", node.Condition->ResultType), node.Condition->GetSpan());
+            // Invalid types are reported where they come from
+            TypeInfo condType = node.Condition->ResultType;
+            if (condType.IsValid() && !condType.IsBool())
+                SPAN_ERROR(node.Condition->GetSpan(), DiagID::ExpectedCondition, condType);
         }
 
         void VerifyVisitor::Visit(ForLoop& node) {
-            node.Init->Accept(*this);
+            if (node.Init) {
+                node.Init->Accept(*this);
+            }
             node.Condition->Accept(*this);
-            node.Update->Accept(*this);
+            if (node.Update) {
+                node.Update->Accept(*this);
+            }
             node.CodeBlock->Accept(*this);
 
-            if (!node.Condition->ResultType.IsBool())
-                SPAN_ERROR(FMT("expectead a boolean, found {}", node.Condition->ResultType), node.Condition->GetSpan());
+            TypeInfo condType = node.Condition->ResultType;
+            if (condType.IsValid() && !condType.IsBool())
+                SPAN_ERROR(node.Condition->GetSpan(), DiagID::ExpectedCondition, condType);
         }
 
         void VerifyVisitor::Visit(WhileLoop& node) {
             node.Condition->Accept(*this);
             node.CodeBlock->Accept(*this);
 
-            if (!node.Condition->ResultType.IsBool())
-                SPAN_ERROR(FMT("expectead a boolean, found {}", node.Condition->ResultType), node.Condition->GetSpan());
+            TypeInfo condType = node.Condition->ResultType;
+            if (condType.IsValid() && !condType.IsBool())
+                SPAN_ERROR(node.Condition->GetSpan(), DiagID::ExpectedCondition, condType);
         }
 
         void VerifyVisitor::Visit(Block& node) {
-            s_Data.Symbols.PushScope();
             for (auto& item : node.Items) {
                 item->Accept(*this);
             }
-            s_Data.Symbols.PopScope();
         }
 
         void VerifyVisitor::Visit(Continue& node) {
@@ -155,9 +185,19 @@ namespace scar {
         }
 
         void VerifyVisitor::Visit(Return& node) {
+            TypeInfo returnType = m_CurrentFunction->ReturnType->ResultType;
+            // A return without a value is only allowed in void functions
+            if (!node.Value) {
+                if (returnType.IsValid() && !returnType.IsVoid()) {
+                    SPAN_ERROR(node.GetSpan(), DiagID::ReturnTypeMismatch);
+                }
+                return;
+            }
+
             node.Value->Accept(*this);
-            if (node.Value->ResultType != s_Data.CurrentFunction->ReturnType->ResultType) {
-                SPAN_ERROR("return value does not match function type", node.GetSpan());
+            TypeInfo valueType = node.Value->ResultType;
+            if (valueType.IsValid() && valueType != returnType) {
+                SPAN_ERROR(node.GetSpan(), DiagID::ReturnTypeMismatch);
             }
         }
 
@@ -166,7 +206,7 @@ namespace scar {
         // EXPRESSIONS
 
         void VerifyVisitor::Visit(FunctionCall& node) {
-            TypeInfo type = s_Data.Symbols.Find(node.Name);
+            TypeInfo type = SymbolType(node.Name);
             // TODO: Verify function argument count and types match called function
 
             for (auto& arg : node.Args) {
@@ -176,9 +216,9 @@ namespace scar {
         }
 
         void VerifyVisitor::Visit(VarAccess& node) {
-            TypeInfo type = s_Data.Symbols.Find(node.Name);
+            TypeInfo type = SymbolType(node.Name);
             if (!type.IsValid()) {
-                SPAN_ERROR(FMT("undeclared variable: {}", node.Name), node.GetSpan());
+                SPAN_ERROR(node.GetSpan(), DiagID::UndeclaredVariable, node.Name);
             }
             node.ResultType = type;
         }
@@ -195,7 +235,7 @@ namespace scar {
                 return;
             }
             if (rhsType.IsVoid()) {
-                SPAN_ERROR("invalid expression type", node.GetSpan());
+                SPAN_ERROR(node.GetSpan(), DiagID::InvalidExpressionType);
                 return;
             }
 
@@ -203,17 +243,17 @@ namespace scar {
             case PrefixOperator::Plus: [[fallthrough]];
             case PrefixOperator::Minus:
                 if (!rhsType.IsInt() && !rhsType.IsFloat())
-                    SPAN_ERROR(FMT("expected an integer or float, found {}", rhsType), node.GetSpan());
+                    SPAN_ERROR(node.GetSpan(), DiagID::ExpectedNumber, rhsType);
                 node.ResultType = rhsType;
                 break;
             case PrefixOperator::Not:
                 if (!rhsType.IsBool())
-                    SPAN_ERROR(FMT("expected a bool, found {}", rhsType), node.RHS->GetSpan());
+                    SPAN_ERROR(node.RHS->GetSpan(), DiagID::ExpectedBool, rhsType);
                 node.ResultType = TypeInfo::Bool;
                 break;
             case PrefixOperator::BitNot:
                 if (!rhsType.IsInt())
-                    SPAN_ERROR(FMT("expected an integer, found {}", rhsType), node.GetSpan());
+                    SPAN_ERROR(node.GetSpan(), DiagID::ExpectedInteger, rhsType);
                 node.ResultType = rhsType;
                 break;
             case PrefixOperator::Increment:
@@ -237,7 +277,7 @@ namespace scar {
                 return;
             }
             if (lhsType.IsVoid()) {
-                SPAN_ERROR("invalid expression type", node.GetSpan());
+                SPAN_ERROR(node.GetSpan(), DiagID::InvalidExpressionType);
                 return;
             }
 
@@ -265,17 +305,19 @@ namespace scar {
                 node.ResultType = node.LHS->ResultType;
 
                 // Make sure LHS is a variable
-                if (dynamic_cast<ast::VarAccess*>(node.LHS.get()) || dynamic_cast<ast::VarDecl*>(node.LHS.get())) {
+                if (dynamic_cast<ast::VarAccess*>(node.LHS) || dynamic_cast<ast::VarDecl*>(node.LHS)) {
                     // Visit RHS
                     node.RHS->Accept(*this);
 
                     // Make sure LHS and RHS types are the same
-                    if (node.LHS->ResultType != node.RHS->ResultType) {
-                        SPAN_ERROR(FMT("type mismatch: {} and {}", node.LHS->ResultType, node.RHS->ResultType), node.GetSpan());
+                    TypeInfo lhsType = node.LHS->ResultType;
+                    TypeInfo rhsType = node.RHS->ResultType;
+                    if (lhsType.IsValid() && rhsType.IsValid() && lhsType != rhsType) {
+                        SPAN_ERROR(node.GetSpan(), DiagID::TypeMismatch, lhsType, rhsType);
                     }
                 }
                 else {
-                    SPAN_ERROR(FMT("binary operator {} requires a variable", node.Type), node.LHS->GetSpan());
+                    SPAN_ERROR(node.LHS->GetSpan(), DiagID::AssignToNonVariable, node.Type);
                 }
 
                 return;
@@ -289,7 +331,7 @@ namespace scar {
             if (!lhsType.IsValid() || !rhsType.IsValid())
                 return;
             if (lhsType.IsVoid() || rhsType.IsVoid()) {
-                SPAN_ERROR("invalid expression type", node.GetSpan());
+                SPAN_ERROR(node.GetSpan(), DiagID::InvalidExpressionType);
                 return;
             }
 
@@ -303,7 +345,7 @@ namespace scar {
             case BinaryOperator::Plus:      [[fallthrough]];
             case BinaryOperator::Minus:
                 if (lhsType != rhsType)
-                    SPAN_ERROR(FMT("type mismatch: {} and {}", lhsType, rhsType), node.LHS->GetSpan());
+                    SPAN_ERROR(node.LHS->GetSpan(), DiagID::TypeMismatch, lhsType, rhsType);
                 node.ResultType = lhsType;
                 break;
             case BinaryOperator::Greater:   [[fallthrough]];
@@ -311,30 +353,30 @@ namespace scar {
             case BinaryOperator::Lesser:    [[fallthrough]];
             case BinaryOperator::LesserEq:
                 if (lhsType != rhsType)
-                    SPAN_ERROR(FMT("type mismatch: {} and {}", lhsType, rhsType), node.LHS->GetSpan());
+                    SPAN_ERROR(node.LHS->GetSpan(), DiagID::TypeMismatch, lhsType, rhsType);
                 node.ResultType = TypeInfo::Bool;
                 break;
             case BinaryOperator::Eq:        [[fallthrough]];
             case BinaryOperator::NotEq:
                 if (lhsType != rhsType)
-                    SPAN_ERROR(FMT("type mismatch: {} and {}", lhsType, rhsType), node.LHS->GetSpan());
+                    SPAN_ERROR(node.LHS->GetSpan(), DiagID::TypeMismatch, lhsType, rhsType);
                 node.ResultType = TypeInfo::Bool;
                 break;
             case BinaryOperator::BitAnd:    [[fallthrough]];
             case BinaryOperator::BitXOr:    [[fallthrough]];
             case BinaryOperator::BitOr:
                 if (!lhsType.IsInt())
-                    SPAN_ERROR(FMT("expected an integer, found {}", lhsType), node.LHS->GetSpan());
+                    SPAN_ERROR(node.LHS->GetSpan(), DiagID::ExpectedInteger, lhsType);
                 if (!rhsType.IsInt())
-                    SPAN_ERROR(FMT("expected an integer, found {}", rhsType), node.RHS->GetSpan());
+                    SPAN_ERROR(node.RHS->GetSpan(), DiagID::ExpectedInteger, rhsType);
                 node.ResultType = LargestType(lhsType, rhsType);
                 break;
             case BinaryOperator::LogicAnd:  [[fallthrough]];
             case BinaryOperator::LogicOr:
                 if (!lhsType.IsBool())
-                    SPAN_ERROR(FMT("expected a bool, found {}", lhsType), node.LHS->GetSpan());
+                    SPAN_ERROR(node.LHS->GetSpan(), DiagID::ExpectedBool, lhsType);
                 if (!rhsType.IsBool())
-                    SPAN_ERROR(FMT("expected a bool, found {}", rhsType), node.RHS->GetSpan());
+                    SPAN_ERROR(node.RHS->GetSpan(), DiagID::ExpectedBool, rhsType);
                 node.ResultType = TypeInfo::Bool;
                 break;
 
@@ -2,11 +2,16 @@
 #include "Parse/AST/AST.hpp"
 
 namespace scar {
+
+    class DiagnosticEngine;
+
     namespace ast {
 
+        // Type checks a resolved Module. The prototypes are checked first, then every function body
+        // on its own, on the thread pool with -fparallel-verify.
         class VerifyVisitor : public Visitor {
         public:
-            VerifyVisitor() = default;
+            explicit VerifyVisitor(DiagnosticEngine& diagnostics);
 
             void Visit(Type& node) override;
 
@@ -34,6 +39,20 @@ namespace scar {
             void Visit(LiteralInteger& node) override;
             void Visit(LiteralFloat& node) override;
             void Visit(LiteralString& node) override;
+
+        private:
+            DiagnosticEngine& m_Diagnostics;
+            // Type of each symbol, indexed by SymbolID. Shared with the visitors of the function bodies,
+            // which only write the slots of their own declarations.
+            std::vector<TypeInfo>* m_SymbolTypes;
+            std::vector<TypeInfo> m_ModuleSymbolTypes;
+            FunctionPrototype* m_CurrentFunction = nullptr;
+
+            // Checks one function body of parent's Module
+            VerifyVisitor(VerifyVisitor& parent, DiagnosticEngine& diagnostics);
+
+            TypeInfo SymbolType(const Ident& name) const;
+            void VerifyBodies(const std::vector<Function*>& functions);
         };
 
     }
@@ -1,22 +1,160 @@
 #include "scarpch.hpp"
 #include "Parse/Interner.hpp"
 
+#include <atomic>
+#include <mutex>
+
 namespace scar {
 
-    std::vector<std::string> Interner::m_Strings;
+    static constexpr size_t ShardBits = 4;
+    static constexpr size_t ShardCount = (size_t)1 << ShardBits;
+    static constexpr size_t InitialTableSize = 256;
+    static constexpr size_t ArenaBlockSize = 64 * 1024;
+
+    // StringIDs are looked up through fixed size pages,
+    // so readers never have to take a lock
+    static constexpr size_t PageBits = 12;
+    static constexpr size_t PageSize = (size_t)1 << PageBits;
+    static constexpr size_t PageCount = (size_t)1 << 16;
+
+    ///////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////////////////////////////////////
+    // DATA
+
+    // Bump allocator for string bytes; blocks never move
+    class StringArena {
+    public:
+        const char* Store(std::string_view str) {
+            if (m_Blocks.empty() || m_BlockUsed + str.size() > m_BlockSize) {
+                // Oversized strings get a block of their own
+                m_BlockSize = std::max(ArenaBlockSize, str.size());
+                m_Blocks.push_back(MakeScope<char[]>(m_BlockSize));
+                m_BlockUsed = 0;
+            }
+            char* data = m_Blocks.back().get() + m_BlockUsed;
+            std::copy(str.begin(), str.end(), data);
+            m_BlockUsed += str.size();
+            return data;
+        }
+
+    private:
+        std::vector<Scope<char[]>> m_Blocks;
+        size_t m_BlockUsed = 0;
+        size_t m_BlockSize = 0;
+    };
+
+    struct InternerSlot {
+        uint32_t Hash = 0;
+        uint32_t Index = 0; // StringID + 1, zero marks an empty slot
+    };
+
+    // Each shard owns the strings whose hash falls into it,
+    // so threads only contend when interning into the same shard
+    struct InternerShard {
+        std::mutex Mutex;
+        std::vector<InternerSlot> Table = std::vector<InternerSlot>(InitialTableSize);
+        size_t Count = 0;
+        StringArena Arena;
+    };
+
+    struct InternerData {
+        InternerShard Shards[ShardCount];
+        std::atomic<std::string_view*> Pages[PageCount] = {};
+        std::atomic<uint32_t> NextID = 0;
+
+        ~InternerData() {
+            for (auto& page : Pages) {
+                delete[] page.load();
+            }
+        }
+    };
+    static InternerData s_Data;
+
+    ///////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////////////////////////////////////
+    // INTERNER
+
+    static uint32_t Hash(std::string_view str) {
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+        for (char c : str) {
+            hash ^= (uint8_t)c;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    static std::string_view* GetPage(size_t index) {
+        std::atomic<std::string_view*>& slot = s_Data.Pages[index];
+        std::string_view* page = slot.load(std::memory_order_acquire);
+        if (page) {
+            return page;
+        }
+
+        // Another thread may be allocating the same page; the loser frees its copy
+        std::string_view* newPage = new std::string_view[PageSize];
+        if (slot.compare_exchange_strong(page, newPage, std::memory_order_acq_rel)) {
+            return newPage;
+        }
+        delete[] newPage;
+        return page;
+    }
+
+    static void Grow(InternerShard& shard) {
+        std::vector<InternerSlot> table(shard.Table.size() * 2);
+        size_t mask = table.size() - 1;
+
+        for (const InternerSlot& slot : shard.Table) {
+            if (slot.Index == 0) {
+                continue;
+            }
+            size_t i = (slot.Hash >> ShardBits) & mask;
+            while (table[i].Index != 0) {
+                i = (i + 1) & mask;
+            }
+            table[i] = slot;
+        }
+        shard.Table = std::move(table);
+    }
 
     Interner::StringID Interner::Intern(std::string_view str) {
-        for (uint32_t i = 0; i < m_Strings.size(); i++) {
-            if (m_Strings[i] == str) {
-                return i;
+        uint32_t hash = Hash(str);
+        InternerShard& shard = s_Data.Shards[hash & (ShardCount - 1)];
+
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        size_t mask = shard.Table.size() - 1;
+
+        // Linear probing until we find the string or an empty slot
+        for (size_t i = (hash >> ShardBits) & mask;; i = (i + 1) & mask) {
+            InternerSlot& slot = shard.Table[i];
+            if (slot.Index == 0) {
+                StringID id = s_Data.NextID.fetch_add(1, std::memory_order_relaxed);
+                if (id >> PageBits >= PageCount) {
+                    SCAR_CRITICAL("too many unique strings");
+                }
+                GetPage(id >> PageBits)[id & (PageSize - 1)] = std::string_view(shard.Arena.Store(str), str.size());
+
+                slot.Hash = hash;
+                slot.Index = id + 1;
+
+                // Keep the load factor under 1/2
+                if (++shard.Count * 2 > shard.Table.size()) {
+                    Grow(shard);
+                }
+                return id;
+            }
+            if (slot.Hash == hash && GetString(slot.Index - 1) == str) {
+                return slot.Index - 1;
             }
         }
-        m_Strings.push_back((std::string)str);
-        return (uint32_t)m_Strings.size() - 1;
     }
 
-    const std::string& Interner::GetString(StringID stringID) {
-        return m_Strings[stringID];
+    std::string_view Interner::GetString(StringID stringID) {
+        return s_Data.Pages[stringID >> PageBits].load(std::memory_order_acquire)[stringID & (PageSize - 1)];
+    }
+
+    uint32_t Interner::GetCount() {
+        return s_Data.NextID.load(std::memory_order_relaxed);
     }
 
 }
\ No newline at end of file
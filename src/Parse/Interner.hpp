@@ -2,15 +2,17 @@
 
 namespace scar {
 
+    // Interner is safe to use from multiple threads at once.
+    // StringIDs are dense and stay the same no matter which thread interned the string.
     class Interner {
     public:
         using StringID = uint32_t;
 
         static StringID Intern(std::string_view str);
-        static const std::string& GetString(StringID stringID);
-
-    private:
-        static std::vector<std::string> m_Strings;
+        // The returned view stays valid for the lifetime of the program
+        static std::string_view GetString(StringID stringID);
+        // Number of unique strings interned so far
+        static uint32_t GetCount();
     };
 
     static std::ostream& operator<<(std::ostream& os, Interner::StringID id) {
@@ -3,6 +3,66 @@
 
 namespace scar {
 
+    namespace {
+        // The classification predicates the lookup tables replaced.
+        // The tables are checked against them when compiling.
+        constexpr bool InRange(uint32_t cp, uint32_t lo, uint32_t hi) { return (lo <= cp) && (cp <= hi); }
+        constexpr bool IsWhitespace(uint32_t cp) {
+            return
+                cp == ' ' || cp == '\t' || cp == '\r' || cp == '\n' ||
+                cp == 0xC || cp == 0x85 ||
+                cp == 0x200E || cp == 0x200F || cp == 0x2028 || cp == 0x2029;
+        }
+        constexpr bool IsBin(uint32_t cp) { return cp == '0' || cp == '1'; }
+        constexpr bool IsOct(uint32_t cp) { return InRange(cp, '0', '7'); }
+        constexpr bool IsDec(uint32_t cp) { return InRange(cp, '0', '9'); }
+        constexpr bool IsHex(uint32_t cp) { return InRange(cp, '0', '9') || InRange(cp, 'a', 'f') || InRange(cp, 'A', 'F'); }
+        constexpr bool IsAlpha(uint32_t cp) { return InRange(cp, 'a', 'z') || InRange(cp, 'A', 'Z'); }
+        constexpr bool IsIdentStart(uint32_t cp) { return IsAlpha(cp) || cp == '_'; }
+        constexpr bool IsIdentBody(uint32_t cp) { return IsAlpha(cp) || IsDec(cp) || cp == '_'; }
+
+        constexpr bool MatchesPredicates(uint32_t cp) {
+            uint8_t cls = range::GetClass(cp);
+            return
+                IsWhitespace(cp) == ((cls & range::Whitespace) != 0) &&
+                IsIdentStart(cp) == ((cls & range::IdentStart) != 0) &&
+                IsIdentBody(cp) == ((cls & range::IdentBody) != 0) &&
+                IsBin(cp) == ((cls & range::Bin) != 0) &&
+                IsOct(cp) == ((cls & range::Oct) != 0) &&
+                IsDec(cp) == ((cls & range::Dec) != 0) &&
+                IsHex(cp) == ((cls & range::Hex) != 0) &&
+                IsAlpha(cp) == ((cls & range::Alpha) != 0);
+        }
+
+        constexpr bool TablesMatchPredicates() {
+            using namespace range::detail;
+
+            // The predicates only accept Codepoints in blocks 0x00 and 0x20,
+            // so check those one by one...
+            for (uint32_t block : { 0x00u, 0x20u }) {
+                for (uint32_t cp = block << BlockBits; cp < (block + 1) << BlockBits; cp++) {
+                    if (!MatchesPredicates(cp)) {
+                        return false;
+                    }
+                }
+            }
+            // ...and make sure every other block is the empty one
+            for (uint32_t block = 0; block < BlockCount; block++) {
+                if (block != 0x00 && block != 0x20 && Unicode.Stage1[block] != 0) {
+                    return false;
+                }
+            }
+            for (uint8_t cls : Unicode.Stage2[0]) {
+                if (cls != 0) {
+                    return false;
+                }
+            }
+            return range::GetClass(0x10FFFF) == 0 && range::GetClass(0xFFFFFFFF) == 0;
+        }
+
+        static_assert(TablesMatchPredicates(), "Codepoint class tables don't match the classification predicates");
+    }
+
     std::string AsString(const Codepoint& cp) {
         std::string s;
         if (cp.Value < 128) {
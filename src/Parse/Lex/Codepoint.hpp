@@ -5,8 +5,8 @@ namespace scar {
     struct Codepoint {
         uint32_t Value;
 
-        Codepoint(unsigned int x = 0) : Value(x) {}
-        Codepoint(int x)              : Value(x) {}
+        constexpr Codepoint(unsigned int x = 0) : Value(x) {}
+        constexpr Codepoint(int x)              : Value(x) {}
 
         bool IsWhitespace() const;
         bool IsChar() const;
@@ -39,44 +39,159 @@ namespace scar {
 
 
     namespace range {
+
+        // Character classes, stored as bit flags in the lookup tables
+        enum CharClass : uint8_t {
+            Whitespace = 1 << 0,
+            IdentStart = 1 << 1,
+            IdentBody  = 1 << 2,
+            Bin        = 1 << 3,
+            Oct        = 1 << 4,
+            Dec        = 1 << 5,
+            Hex        = 1 << 6,
+            Alpha      = 1 << 7,
+        };
+
+        namespace detail {
+            struct ClassRange {
+                uint32_t Lo, Hi;
+                uint8_t Class;
+            };
+
+            // Every classified Codepoint range; the tables below are generated from this
+            constexpr ClassRange ClassRanges[] = {
+                { ' ',    ' ',    Whitespace },
+                { '\t',   '\t',   Whitespace },
+                { '\n',   '\n',   Whitespace },
+                { 0xC,    0xC,    Whitespace }, // ^L
+                { '\r',   '\r',   Whitespace },
+                { 0x85,   0x85,   Whitespace },
+                { 0x200E, 0x200F, Whitespace }, // LTR, RTL
+                { 0x2028, 0x2029, Whitespace }, // Line Separator, Paragraph Separator
+
+                { '0', '1', Bin | Oct | Dec | Hex | IdentBody },
+                { '2', '7',       Oct | Dec | Hex | IdentBody },
+                { '8', '9',             Dec | Hex | IdentBody },
+                { 'a', 'f', Hex | Alpha | IdentStart | IdentBody },
+                { 'A', 'F', Hex | Alpha | IdentStart | IdentBody },
+                { 'g', 'z',       Alpha | IdentStart | IdentBody },
+                { 'G', 'Z',       Alpha | IdentStart | IdentBody },
+                { '_', '_',               IdentStart | IdentBody },
+            };
+
+            constexpr uint8_t ClassOf(uint32_t cp) {
+                uint8_t cls = 0;
+                for (const ClassRange& range : ClassRanges) {
+                    if (range.Lo <= cp && cp <= range.Hi) {
+                        cls |= range.Class;
+                    }
+                }
+                return cls;
+            }
+
+            constexpr uint32_t UnicodeEnd = 0x110000;
+            constexpr uint32_t BlockBits = 8;
+            constexpr uint32_t BlockSize = 1 << BlockBits;
+            constexpr uint32_t BlockCount = UnicodeEnd >> BlockBits;
+
+            // First level: one class per byte value
+            constexpr std::array<uint8_t, 256> MakeByteTable() {
+                std::array<uint8_t, 256> table = {};
+                for (uint32_t cp = 0; cp < 256; cp++) {
+                    table[cp] = ClassOf(cp);
+                }
+                return table;
+            }
+
+            constexpr bool BlockIsEmpty(uint32_t block) {
+                for (const ClassRange& range : ClassRanges) {
+                    if (range.Lo >> BlockBits <= block && block <= range.Hi >> BlockBits) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            // Blocks of 256 Codepoints that contain at least one classified Codepoint
+            constexpr uint32_t CountUsedBlocks() {
+                uint32_t count = 0;
+                for (uint32_t block = 0; block < BlockCount; block++) {
+                    if (!BlockIsEmpty(block)) {
+                        count++;
+                    }
+                }
+                return count;
+            }
+
+            struct UnicodeTable {
+                // Block of every Codepoint, index 0 is an all-zero block
+                std::array<uint8_t, BlockCount> Stage1 = {};
+                std::array<std::array<uint8_t, BlockSize>, CountUsedBlocks() + 1> Stage2 = {};
+            };
+
+            // Second level: Codepoint >> 8 selects a shared block of 256 classes
+            constexpr UnicodeTable MakeUnicodeTable() {
+                UnicodeTable table;
+                uint8_t next = 1;
+                for (uint32_t block = 0; block < BlockCount; block++) {
+                    if (BlockIsEmpty(block)) {
+                        continue;
+                    }
+                    table.Stage1[block] = next;
+                    for (uint32_t i = 0; i < BlockSize; i++) {
+                        table.Stage2[next][i] = ClassOf((block << BlockBits) | i);
+                    }
+                    next++;
+                }
+                return table;
+            }
+
+            inline constexpr std::array<uint8_t, 256> ByteTable = MakeByteTable();
+            inline constexpr UnicodeTable Unicode = MakeUnicodeTable();
+        }
+
+        // Get the CharClass flags of a Codepoint
+        constexpr uint8_t GetClass(Codepoint cp) {
+            if (cp.Value < 256) {
+                return detail::ByteTable[cp.Value];
+            }
+            if (cp.Value >= detail::UnicodeEnd) {
+                return 0;
+            }
+            return detail::Unicode.Stage2[detail::Unicode.Stage1[cp.Value >> detail::BlockBits]][cp.Value & (detail::BlockSize - 1)];
+        }
+
+        constexpr bool HasClass(Codepoint cp, uint8_t cls) { return (GetClass(cp) & cls) != 0; }
+
         // Check if the Codepoint is a C-style char
         static bool IsChar(Codepoint cp) { return cp <= 0xffff; }
 
         // Check if the Codepoint is within a certain range
         static bool InRange(Codepoint cp, Codepoint lo, Codepoint hi) { return (lo <= cp) && (cp <= hi); }
 
-        static bool IsWhitespace(Codepoint cp) {
-            return
-                cp == ' ' || cp == '\t' || cp == '\r' || cp == '\n' ||
-                cp == 0xC ||     // ^L
-                cp == 0x85 ||
-                cp == 0x200E ||  // LTR
-                cp == 0x200F ||  // RTL
-                cp == 0x2028 ||  // Line Separator
-                cp == 0x2029;    // Paragraph Separator
-        }
-        static bool IsBin(Codepoint cp) { return cp == '0' || cp == '1'; }
-        static bool IsOct(Codepoint cp) { return InRange(cp, '0', '7'); }
-        static bool IsDec(Codepoint cp) { return InRange(cp, '0', '9'); }
-        static bool IsHex(Codepoint cp) { return InRange(cp, '0', '9') || InRange(cp, 'a', 'f') || InRange(cp, 'A', 'F'); }
-        static bool IsAlpha(Codepoint cp) { return InRange(cp, 'a', 'z') || InRange(cp, 'A', 'Z'); }
-        static bool IsAlnum(Codepoint cp) { return IsAlpha(cp) || IsDec(cp); }
+        static bool IsWhitespace(Codepoint cp) { return HasClass(cp, Whitespace); }
+        static bool IsBin(Codepoint cp) { return HasClass(cp, Bin); }
+        static bool IsOct(Codepoint cp) { return HasClass(cp, Oct); }
+        static bool IsDec(Codepoint cp) { return HasClass(cp, Dec); }
+        static bool IsHex(Codepoint cp) { return HasClass(cp, Hex); }
+        static bool IsAlpha(Codepoint cp) { return HasClass(cp, Alpha); }
+        static bool IsAlnum(Codepoint cp) { return HasClass(cp, Alpha | Dec); }
         static bool IsEOF(Codepoint cp) { return cp.Value == '\0'; }
 
         // Check if the Codepoint can start an identifier
-        static bool IsIdentStart(Codepoint cp) { return IsAlpha(cp) || cp == '_'; }
+        static bool IsIdentStart(Codepoint cp) { return HasClass(cp, IdentStart); }
         // Check if the Codepoint can continue an identifier
-        static bool IsIdentBody(Codepoint cp) { return IsAlnum(cp) || cp == '_'; }
+        static bool IsIdentBody(Codepoint cp) { return HasClass(cp, IdentBody); }
 
         // Get a number from a Codepoint
         // Returns (-1) if it's not a valid number
         static int GetNum(Codepoint cp, unsigned int base) {
             unsigned int val = 0;
 
-            if (range::InRange(cp, '0', '9'))      { val = cp - '0'; }
-            else if (range::InRange(cp, 'a', 'f')) { val = cp - 'a' + 10; }
-            else if (range::InRange(cp, 'A', 'F')) { val = cp - 'A' + 10; }
-            else { return -1; }
+            if (!IsHex(cp))           { return -1; }
+            else if (cp.Value <= '9') { val = cp - '0'; }
+            else if (cp.Value >= 'a') { val = cp - 'a' + 10; }
+            else                      { val = cp - 'A' + 10; }
 
             return (val < base) ? val : -1;
         }
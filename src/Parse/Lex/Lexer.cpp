@@ -1,7 +1,8 @@
 #include "scarpch.hpp"
 #include "Parse/Lex/Lexer.hpp"
+#include "Core/ThreadPool.hpp"
 
-#define SPAN_ERROR(...) SCAR_ERROR("{}: {}", GetSpan(), FMT(__VA_ARGS__))
+#include <thread>
 
 namespace scar {
 
@@ -9,68 +10,204 @@ namespace scar {
     ///////////////////////////////////////////////////////////////////////////
     // MISCELANEOUS
 
-    static std::unordered_map<std::string_view, Token::TokenType> KeywordMap = {
-        { "func",     Token::Func },
-        { "if",       Token::If },
-        { "else",     Token::Else },
-        { "for",      Token::For },
-        { "while",    Token::While },
-        { "loop",     Token::Loop },
-        { "var",      Token::Var },
-        { "continue", Token::Continue },
-        { "break",    Token::Break },
-        { "return",   Token::Return },
-        { "as",       Token::As },
-
-        { "true",  Token::True },
-        { "false", Token::False },
-
-        { "bool", Token::Bool },
-
-        { "i8",   Token::I8 },
-        { "i16",  Token::I16 },
-        { "i32",  Token::I32 },
-        { "i64",  Token::I64 },
-
-        { "u8",   Token::U8 },
-        { "u16",  Token::U16 },
-        { "u32",  Token::U32 },
-        { "u64",  Token::U64 },
-
-        { "f32",  Token::F32 },
-        { "f64",  Token::F64 },
-    };
+    // Sized integer and float type names: i8 i16 i32 i64, u8 u16 u32 u64, f32 f64
+    static Token::TokenType GetSizedTypeKeyword(char prefix, std::string_view bits) {
+        int index;
+        if (bits == "8")       { index = 0; }
+        else if (bits == "16") { index = 1; }
+        else if (bits == "32") { index = 2; }
+        else if (bits == "64") { index = 3; }
+        else { return Token::Ident; }
+
+        switch (prefix) {
+        case 'i': return (Token::TokenType)(Token::I8 + index);
+        case 'u': return (Token::TokenType)(Token::U8 + index);
+        case 'f': return index >= 2 ? (Token::TokenType)(Token::F32 + index - 2) : Token::Ident;
+        default:  return Token::Ident;
+        }
+    }
+
+    // Get the keyword Token::Type of an identifier, or Token::Ident if it isn't one.
+    // Switching on the length and first character leaves at most
+    // a couple of string comparisons for any identifier.
+    static Token::TokenType GetKeyword(std::string_view str) {
+        switch (str.size()) {
+        case 2:
+            switch (str[0]) {
+            case 'i': return str[1] == 'f' ? Token::If : GetSizedTypeKeyword('i', str.substr(1));
+            case 'u': return GetSizedTypeKeyword('u', str.substr(1));
+            case 'a': return str[1] == 's' ? Token::As : Token::Ident;
+            }
+            break;
+        case 3:
+            switch (str[0]) {
+            case 'f': return str == "for" ? Token::For : GetSizedTypeKeyword('f', str.substr(1));
+            case 'v': return str == "var" ? Token::Var : Token::Ident;
+            case 'i': [[fallthrough]];
+            case 'u': return GetSizedTypeKeyword(str[0], str.substr(1));
+            }
+            break;
+        case 4:
+            switch (str[0]) {
+            case 'f': return str == "func" ? Token::Func : Token::Ident;
+            case 'e': return str == "else" ? Token::Else : Token::Ident;
+            case 'l': return str == "loop" ? Token::Loop : Token::Ident;
+            case 't': return str == "true" ? Token::True : Token::Ident;
+            case 'b': return str == "bool" ? Token::Bool : Token::Ident;
+            }
+            break;
+        case 5:
+            switch (str[0]) {
+            case 'w': return str == "while" ? Token::While : Token::Ident;
+            case 'b': return str == "break" ? Token::Break : Token::Ident;
+            case 'f': return str == "false" ? Token::False : Token::Ident;
+            }
+            break;
+        case 6:
+            return str == "return" ? Token::Return : Token::Ident;
+        case 8:
+            return str == "continue" ? Token::Continue : Token::Ident;
+        }
+        return Token::Ident;
+    }
 
     ///////////////////////////////////////////////////////////////////////////
     ///////////////////////////////////////////////////////////////////////////
     // LEXER
 
     Lexer::Lexer(const std::string& path) :
-        m_Reader(path)
+        Lexer(SourceMap::Load(path), 0, std::string_view::npos, Session::GetDiagnostics())
     {}
 
+    Lexer::Lexer(SourceFile* sourceFile, size_t begin, size_t end, DiagnosticEngine& diagnostics) :
+        m_Reader(sourceFile, begin, end),
+        m_Diagnostics(diagnostics)
+    {
+        if (m_Reader.HasInvalidUTF8()) {
+            m_Diagnostics.Report(TextSpan(sourceFile->GetID(), (uint32_t)sourceFile->GetInvalidUTF8Offset(), 1), DiagID::InvalidUTF8);
+        }
+    }
+
     void Lexer::Bump(unsigned int n) {
         m_Reader.Bump(n);
     }
 
     TokenStream Lexer::Lex() {
         TokenStream tokenStream;
+        // Roughly one Token every few bytes of source
+        tokenStream.reserve(m_Reader.GetRemainingLength() / 4 + 1);
         do {
             tokenStream.push_back(GetNextToken());
-        } while (!tokenStream.back().IsEOF()); // Check if last token was EOF
+        } while (tokenStream.GetType(tokenStream.size() - 1) != Token::EndOfFile); // Check if last token was EOF
         return tokenStream;
     }
 
-    Token Lexer::GetNextToken() {
-        try { return GetNextTokenInner(); }
-        catch (CompilerError& e) {
-            e.OnCatch();
-            return Token(GetSpan());
+    // Find offsets the text can be split at without cutting a Token or comment in half:
+    // right after a newline that isn't inside a block comment, roughly every chunkSize bytes.
+    // The returned offsets start with 0 and end with the text's length.
+    static std::vector<size_t> FindChunkBoundaries(std::string_view text, size_t chunkSize) {
+        constexpr size_t npos = std::string_view::npos;
+
+        std::vector<size_t> boundaries = { 0 };
+        size_t target = chunkSize;
+        size_t pos = 0;
+
+        // Only comments can hide newlines, so jump from one comment start to the next
+        while (pos < text.length()) {
+            size_t slash = std::min(text.find('/', pos), text.length());
+
+            // Split at the first newline past each target before the comment
+            while (target <= slash) {
+                size_t newline = text.find('\n', std::max(pos, target - 1));
+                if (newline >= slash || newline + 1 == text.length()) {
+                    break;
+                }
+                boundaries.push_back(newline + 1);
+                target = newline + 1 + chunkSize;
+            }
+
+            if (slash + 1 >= text.length()) {
+                break;
+            }
+            if (text[slash + 1] == '/') {
+                // Line comments end at the newline, which may still be a boundary
+                pos = std::min(text.find('\n', slash + 2), text.length());
+            }
+            else if (text[slash + 1] == '*') {
+                size_t close = text.find("*/", slash + 2);
+                pos = close == npos ? text.length() : close + 2;
+            }
+            else {
+                pos = slash + 1;
+            }
         }
+
+        boundaries.push_back(text.length());
+        return boundaries;
     }
 
-    Token Lexer::GetNextTokenInner() {
-        SkipWhitespaceAndComments();
+    TokenStream Lexer::LexParallel(const std::string& path, ThreadPool& pool) {
+        // Smaller chunks aren't worth a thread
+        static constexpr size_t MinChunkSize = 256 * 1024;
+
+        SourceFile* sourceFile = SourceMap::Load(path);
+        if (!sourceFile) {
+            TokenStream tokens;
+            tokens.push_back(Token(Token::EndOfFile, TextSpan()));
+            return tokens;
+        }
+
+        // More chunks than cores only adds the cost of splitting and joining, zero means the count is unknown
+        size_t threadCount = pool.GetThreadCount();
+        if (unsigned int cores = std::thread::hardware_concurrency()) {
+            threadCount = std::min<size_t>(threadCount, cores);
+        }
+
+        size_t length = sourceFile->GetLength();
+        size_t chunkCount = std::min(threadCount, length / MinChunkSize);
+        // Invalid UTF-8 leaves nothing to lex
+        if (chunkCount <= 1 || sourceFile->GetInvalidUTF8Offset() != std::string_view::npos) {
+            return Lexer(path).Lex();
+        }
+
+        std::vector<size_t> boundaries = FindChunkBoundaries(sourceFile->GetString(0, length), length / chunkCount);
+        chunkCount = boundaries.size() - 1;
+
+        // Chunks are read with file offsets, so their Tokens need no fixing up
+        std::vector<TokenStream> chunks(chunkCount);
+        std::vector<DiagnosticEngine> diagnostics(chunkCount);
+        std::vector<ChunkNames> names(chunkCount);
+        pool.ParallelFor(chunkCount, [&](size_t i) {
+            Lexer lexer(sourceFile, boundaries[i], boundaries[i + 1], diagnostics[i]);
+            lexer.m_ChunkNames = &names[i];
+            chunks[i] = lexer.Lex();
+        });
+
+        // Intern in file order so the StringIDs don't depend on how the file was split
+        std::vector<std::vector<Interner::StringID>> ids(chunkCount);
+        for (size_t i = 0; i < chunkCount; i++) {
+            ids[i].reserve(names[i].Names.size());
+            for (std::string_view name : names[i].Names) {
+                ids[i].push_back(Interner::Intern(name));
+            }
+        }
+        pool.ParallelFor(chunkCount, [&](size_t i) {
+            chunks[i].RemapNames(ids[i]);
+        });
+
+        // Report errors in file order, as a single Lexer would have
+        for (DiagnosticEngine& chunkDiagnostics : diagnostics) {
+            Session::GetDiagnostics().Append(chunkDiagnostics);
+        }
+
+        // Only the last chunk's EOF is the file's EOF
+        return TokenStream::Join(chunks, pool);
+    }
+
+    Token Lexer::GetNextToken() {
+        if (!SkipWhitespaceAndComments()) {
+            return Token(GetSpan());
+        }
         m_TokenStartPosition = GetPosition();
 
         // EOF
@@ -88,13 +225,20 @@ namespace scar {
                 Bump();
             } while (range::IsIdentBody(GetCurr()));
 
-            std::string_view ident = m_Reader.GetSourceFile()->GetString(m_TokenStartPosition.Index, GetPosition().Index - m_TokenStartPosition.Index);
-            auto iter = KeywordMap.find(ident);
-            if (iter != KeywordMap.end()) {
-                return Token(iter->second, GetSpan());
+            std::string_view ident = GetString();
+            Token::TokenType keyword = GetKeyword(ident);
+            if (keyword != Token::Ident) {
+                return Token(keyword, GetSpan());
             }
 
-            return Token(Token::Ident, GetString(), GetSpan());
+            if (m_ChunkNames) {
+                auto [it, inserted] = m_ChunkNames->Indices.try_emplace(ident, (Interner::StringID)m_ChunkNames->Names.size());
+                if (inserted) {
+                    m_ChunkNames->Names.push_back(ident);
+                }
+                return Token(Token::Ident, it->second, GetSpan());
+            }
+            return Token(Token::Ident, ident, GetSpan());
         }
 
         // Symbols
@@ -187,11 +331,11 @@ namespace scar {
 
         default:
             Bump();
-            SPAN_ERROR("unrecognized symbol '{}'", GetString());
+            return Error(DiagID::UnrecognizedSymbol, GetString());
         }
     }
 
-    void Lexer::SkipWhitespaceAndComments() {
+    bool Lexer::SkipWhitespaceAndComments() {
         while (GetCurr().IsWhitespace()) {
             Bump();
         }
@@ -201,7 +345,7 @@ namespace scar {
                 while (GetCurr() != '\n' && !GetCurr().IsEOF()) {
                     Bump();
                 }
-                SkipWhitespaceAndComments();
+                return SkipWhitespaceAndComments();
             }
             else if (GetNext() == '*') {
                 m_TokenStartPosition = GetPosition();
@@ -209,14 +353,16 @@ namespace scar {
                 while (!(GetCurr() == '*' && GetNext() == '/')) {
                     // Don't allow unclosed comments at end of file
                     if (GetCurr().IsEOF()) {
-                        SPAN_ERROR("unexpected end of file in comment");
+                        m_Diagnostics.Report(GetSpan(), DiagID::UnterminatedComment);
+                        return false;
                     }
                     Bump();
                 }
                 Bump(2);
-                SkipWhitespaceAndComments();
+                return SkipWhitespaceAndComments();
             }
         }
+        return true;
     }
 
     ///////////////////////////////////////////////////////////////////////////
@@ -311,7 +457,7 @@ namespace scar {
                 // Make sure there's a number after the prefix
                 if (!GetCurr().IsBin()) {
                     Bump();
-                    SPAN_ERROR("binary number missing value");
+                    return Error(DiagID::MissingBinaryValue);
                 }
             }
             else if (GetNext() == 'o') {
@@ -320,7 +466,7 @@ namespace scar {
                 // Make sure there's a number after the prefix
                 if (!GetCurr().IsOct()) {
                     Bump();
-                    SPAN_ERROR("octal number missing value");
+                    return Error(DiagID::MissingOctalValue);
                 }
             }
             else if (GetNext() == 'x') {
@@ -329,7 +475,7 @@ namespace scar {
                 // Make sure there's a number after the prefix
                 if (!GetCurr().IsHex()) {
                     Bump();
-                    SPAN_ERROR("hexadecimal number missing value");
+                    return Error(DiagID::MissingHexValue);
                 }
             }
         }
@@ -342,10 +488,12 @@ namespace scar {
         }
 
         ReadFraction();
-        ReadExponent();
+        if (!ReadExponent()) {
+            return Error(DiagID::MissingExponent);
+        }
 
         if (base != 10) {
-            SPAN_ERROR("only decimal numbers support fractions and exponents");
+            return Error(DiagID::NonDecimalFraction);
         }
 
         return Token(Token::LitFloat, Token::F64, StringToFloat(GetString()), GetSpan());
@@ -366,7 +514,7 @@ namespace scar {
         }
     }
 
-    void Lexer::ReadExponent() {
+    bool Lexer::ReadExponent() {
         if (GetCurr() == 'e' || GetCurr() == 'E') {
             Bump();
 
@@ -375,13 +523,12 @@ namespace scar {
             }
 
             // Make sure exponent has valid value
-            if (GetCurr().IsDec()) {
-                ReadDigits(10);
-            }
-            else {
-                SPAN_ERROR("exponent requires a value");
+            if (!GetCurr().IsDec()) {
+                return false;
             }
+            ReadDigits(10);
         }
+        return true;
     }
 
     ///////////////////////////////////////////////////////////////////////////
@@ -414,7 +561,7 @@ namespace scar {
 
         if (!range::IsChar(value)) {
             value = 0xFFFD;
-            SPAN_ERROR("invalid numeric escape : '{}'", GetString());
+            m_Diagnostics.Report(GetSpan(), DiagID::InvalidNumericEscape, GetString());
         }
 
         return Codepoint(value);
@@ -3,22 +3,42 @@
 #include "Parse/Interner.hpp"
 #include "Parse/Token.hpp"
 
+namespace scar { class ThreadPool; }
+
 namespace scar {
 
     class Lexer {
     public:
+        // Errors are reported to the Session's diagnostics
         explicit Lexer(const std::string& path);
+        // Lex only the [begin, end) byte range of an already loaded SourceFile
+        Lexer(SourceFile* sourceFile, size_t begin, size_t end, DiagnosticEngine& diagnostics);
 
         // Return a TokenStream of the current file
         TokenStream Lex();
+        // Split the file into chunks at newlines outside of comments,
+        // lex them on the pool's threads and join them into one TokenStream
+        static TokenStream LexParallel(const std::string& path, ThreadPool& pool);
+        // Lex the next Token, returns EOF once the end of the file is reached.
+        // Errors are reported and give an invalid Token.
+        Token GetNextToken();
 
         // Get the current SourceFile
         SourceFile* GetSourceFile()             { return m_Reader.GetSourceFile(); }
         const SourceFile* GetSourceFile() const { return m_Reader.GetSourceFile(); }
 
     private:
+        // Identifiers of a chunk in order of first appearance, its Tokens hold indices into Names.
+        // They're interned in chunk order afterwards so StringIDs match a single Lexer's.
+        struct ChunkNames {
+            std::unordered_map<std::string_view, Interner::StringID> Indices;
+            std::vector<std::string_view> Names;
+        };
+
         UTFReader m_Reader;
         TextPosition m_TokenStartPosition;
+        DiagnosticEngine& m_Diagnostics;
+        ChunkNames* m_ChunkNames = nullptr;
 
         void Bump(unsigned int n = 1);
         // Get the current Codepoint
@@ -29,16 +49,19 @@ namespace scar {
         // Get the current Token's position
         TextPosition GetPosition() const { return m_Reader.GetPosition(); }
         // Get the current Token's span
-        TextSpan GetSpan() const { return TextSpan(GetSourceFile(), m_TokenStartPosition, GetPosition()); }
+        TextSpan GetSpan() const { return TextSpan(GetSourceFile()->GetID(), m_TokenStartPosition, GetPosition()); }
         // Get the current Token's raw string
         std::string_view GetString() const { return GetSourceFile()->GetString(m_TokenStartPosition.Index, GetPosition().Index - m_TokenStartPosition.Index); }
 
-        // Main tokenization function
-        Token GetNextToken();
-        Token GetNextTokenInner();
+        // Report an error over the current Token's span, returns an invalid Token
+        template<typename... Args>
+        Token Error(DiagID id, Args&&... args) {
+            m_Diagnostics.Report(GetSpan(), id, std::forward<Args>(args)...);
+            return Token(GetSpan());
+        }
 
-        // Read past whitespace and comments
-        void SkipWhitespaceAndComments();
+        // Read past whitespace and comments, returns false if a comment isn't closed
+        bool SkipWhitespaceAndComments();
 
         // Main number tokenization function
         Token LexNumber();
@@ -46,8 +69,8 @@ namespace scar {
         void ReadDigits(unsigned int base);
         // Read past floating point fraction
         void ReadFraction();
-        // Read past floating point exponent
-        void ReadExponent();
+        // Read past floating point exponent, returns false if it has no value
+        bool ReadExponent();
 
         // Read past an escaped hex code, return it as a Codepoint
         Codepoint ReadHexEscape(unsigned int length, Codepoint delim);
@@ -1,33 +1,199 @@
 #include "scarpch.hpp"
 #include "Parse/Lex/SourceFile.hpp"
+#include "Core/SIMD.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifdef SCAR_PLATFORM_LINUX
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 namespace scar {
 
     std::vector<Scope<SourceFile>> SourceMap::s_Files;
+    std::unordered_map<std::string, FileID> SourceMap::s_FileIDs;
 
-    SourceFile::SourceFile(const std::string& path) :
-        m_File(path),
-        m_FilePath(path)
+    SourceFile::SourceFile(const std::string& path, FileID id) :
+        m_FilePath(path),
+        m_ID(id)
     {
-        if (!m_File.is_open()) {
-            SCAR_ERROR("failed to open file: {}", path);
+        if (!Map() && !Read()) {
+            Session::GetDiagnostics().Report(DiagID::FileOpenFailed, m_FilePath);
+            m_IsValid = false;
+            return;
+        }
+
+        // Spans store 32-bit offsets
+        if (m_Text.length() > std::numeric_limits<uint32_t>::max()) {
+            Session::GetDiagnostics().Report(DiagID::FileTooLarge, path);
+            m_IsValid = false;
+            return;
+        }
+
+        BuildLineStarts();
+        ValidateUTF8();
+    }
+
+    SourceFile::~SourceFile() {
+#ifdef SCAR_PLATFORM_LINUX
+        if (m_Mapping) {
+            munmap(m_Mapping, m_MappingSize);
+        }
+#endif
+    }
+
+    bool SourceFile::Map() {
+#ifdef SCAR_PLATFORM_LINUX
+        if (m_FilePath == "-") {
+            return false;
+        }
+
+        // Files that can't be opened fail again in Read
+        int fd = open(m_FilePath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        // Only regular files can be mapped; empty files can't be mapped at all
+        struct stat info;
+        if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+            close(fd);
+            return false;
+        }
+
+        void* mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
         }
+        madvise(mapping, (size_t)info.st_size, MADV_SEQUENTIAL);
 
-        m_File.seekg(0, std::ios::end);
-        auto length = m_File.tellg();
-        m_File.seekg(0, std::ios::beg);
+        m_Mapping = mapping;
+        m_MappingSize = (size_t)info.st_size;
+        m_Text = std::string_view((const char*)m_Mapping, m_MappingSize);
+        return true;
+#else
+        return false;
+#endif
+    }
 
-        m_Text.resize(length);
-        m_File.read(&m_Text[0], length);
+    bool SourceFile::Read() {
+        std::ostringstream stream;
+
+        if (m_FilePath == "-") {
+            stream << std::cin.rdbuf();
+        }
+        else {
+            std::ifstream file(m_FilePath, std::ios::binary);
+            if (!file.is_open()) {
+                return false;
+            }
+            // Streams don't have to be seekable, so read until the end
+            stream << file.rdbuf();
+        }
 
-        m_File.close();
+        m_Buffer = stream.str();
+        m_Text = m_Buffer;
+        return true;
     }
 
     std::string_view SourceFile::GetString(size_t start, size_t count, bool stopAtNewline) const {
-        std::string_view str = std::string_view(m_Text).substr(start, count);
+        std::string_view str = m_Text.substr(start, count);
         return stopAtNewline ? str.substr(0, str.find_first_of('\n')) : str;
     }
 
+    LineCol SourceFile::LineColFor(size_t offset) const {
+        // Find the last line that starts at or before the offset
+        auto iter = std::upper_bound(m_LineStarts.begin(), m_LineStarts.end(), offset) - 1;
+        uint32_t line = (uint32_t)(iter - m_LineStarts.begin()) + 1;
+
+        // Count codepoints by skipping UTF-8 continuation bytes
+        uint32_t col = 1;
+        for (size_t i = *iter; i < offset && i < m_Text.length(); i++) {
+            if ((m_Text[i] & 0xC0) != 0x80) {
+                col++;
+            }
+        }
+
+        return LineCol{ line, col };
+    }
+
+    std::string_view SourceFile::GetLine(uint32_t lineNo) const {
+        if (lineNo == 0 || lineNo > m_LineStarts.size()) {
+            return {};
+        }
+
+        size_t start = m_LineStarts[lineNo - 1];
+        size_t end = lineNo < m_LineStarts.size() ? m_LineStarts[lineNo] - 1 : m_Text.length();
+        if (end > start && m_Text[end - 1] == '\r') {
+            end--;
+        }
+        return m_Text.substr(start, end - start);
+    }
+
+    void SourceFile::BuildLineStarts() {
+        // Assume an average line length to avoid most reallocations
+        m_LineStarts.reserve(m_Text.length() / 32 + 1);
+        m_LineStarts.push_back(0);
+
+        simd::ForEachByte(m_Text.data(), m_Text.data() + m_Text.length(), '\n', [this](size_t offset) {
+            m_LineStarts.push_back((uint32_t)offset + 1);
+        });
+    }
+
+    // Get the length of the valid UTF-8 sequence starting with a non-ASCII byte,
+    // or zero if it's invalid (overlong, surrogate, out of range or truncated)
+    static size_t ValidSequenceLength(const uint8_t* ptr, const uint8_t* end) {
+        uint8_t lead = ptr[0];
+        size_t length;
+        uint8_t lo = 0x80, hi = 0xBF; // Allowed range of the first continuation byte
+
+        if (lead >= 0xC2 && lead <= 0xDF)      { length = 2; }
+        else if (lead == 0xE0)                 { length = 3; lo = 0xA0; }
+        else if (lead == 0xED)                 { length = 3; hi = 0x9F; }
+        else if (lead >= 0xE1 && lead <= 0xEF) { length = 3; }
+        else if (lead == 0xF0)                 { length = 4; lo = 0x90; }
+        else if (lead == 0xF4)                 { length = 4; hi = 0x8F; }
+        else if (lead >= 0xF1 && lead <= 0xF3) { length = 4; }
+        else { return 0; }
+
+        if ((size_t)(end - ptr) < length || ptr[1] < lo || ptr[1] > hi) {
+            return 0;
+        }
+        for (size_t i = 2; i < length; i++) {
+            if ((ptr[i] & 0xC0) != 0x80) {
+                return 0;
+            }
+        }
+        return length;
+    }
+
+    void SourceFile::ValidateUTF8() {
+        const uint8_t* begin = (const uint8_t*)m_Text.data();
+        const uint8_t* end = begin + m_Text.length();
+        const uint8_t* ptr = begin;
+
+        // Skip ASCII runs with SIMD and only check the multibyte sequences in between
+        while (true) {
+            ptr += simd::FindNonASCII((const char*)ptr, (const char*)end);
+            if (ptr == end) {
+                return;
+            }
+
+            size_t length = ValidSequenceLength(ptr, end);
+            if (length == 0) {
+                m_InvalidUTF8Offset = (size_t)(ptr - begin);
+                return;
+            }
+            ptr += length;
+        }
+    }
+
     std::string SourceFile::GetFileName() const {
         auto dashPos = m_FilePath.find_last_of('/');
         auto namePos = (dashPos == 0 && m_FilePath[0] != '/') ? 0 : dashPos + 1;
@@ -35,22 +201,37 @@ namespace scar {
     }
 
     SourceFile* SourceMap::Load(const std::string& path) {
-        if (SourceFile* file = Find(path)) {
-            return file;
+        std::string canonicalPath = Canonicalize(path);
+
+        auto iter = s_FileIDs.find(canonicalPath);
+        if (iter != s_FileIDs.end()) {
+            return Get(iter->second);
         }
 
         // Load the file and add it to the list
-        s_Files.push_back(MakeScope<SourceFile>(path));
+        FileID id = (FileID)s_Files.size();
+        s_Files.push_back(MakeScope<SourceFile>(path, id));
+        if (!s_Files.back()->IsValid()) {
+            s_Files.pop_back();
+            return nullptr;
+        }
+        s_FileIDs.emplace(std::move(canonicalPath), id);
         return s_Files.back().get();
     }
 
     SourceFile* SourceMap::Find(const std::string& path) {
-        for (auto& f : s_Files) {
-            if (f->GetFilePath() == path) {
-                return f.get();
-            }
+        auto iter = s_FileIDs.find(Canonicalize(path));
+        return iter != s_FileIDs.end() ? Get(iter->second) : nullptr;
+    }
+
+    std::string SourceMap::Canonicalize(const std::string& path) {
+        if (path == "-") {
+            return path;
         }
-        return nullptr;
+        // Files that don't exist keep a normalized version of their path
+        std::error_code error;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+        return error ? std::filesystem::path(path).lexically_normal().string() : canonical.string();
     }
 
 }
\ No newline at end of file
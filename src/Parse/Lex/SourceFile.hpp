@@ -1,34 +1,77 @@
 #pragma once
-#include <fstream>
 
 namespace scar {
 
+    using FileID = uint32_t;
+
+    struct LineCol {
+        uint32_t Line, Col;
+    };
+
     class SourceFile {
     public:
-        explicit SourceFile(const std::string& path);
+        // Regular files are memory-mapped, anything else (pipes, "-" for stdin) is read into a buffer.
+        // Failing to load the file is reported and leaves it invalid.
+        SourceFile(const std::string& path, FileID id);
+        ~SourceFile();
+
+        SourceFile(const SourceFile&) = delete;
+        void operator=(const SourceFile&) = delete;
 
         std::string_view GetString(size_t start, size_t count, bool stopAtNewline = false) const;
-        char GetChar(size_t pos) const { return m_Text[pos]; }
+        // Returns '\0' past the end of the file
+        char GetChar(size_t pos) const { return pos < m_Text.length() ? m_Text[pos] : '\0'; }
 
         std::string GetFileName() const;
         const std::string& GetFilePath() const { return m_FilePath; }
         size_t GetLength() const { return m_Text.length(); }
+        FileID GetID() const { return m_ID; }
+        bool IsValid() const { return m_IsValid; }
+
+        // Get the 1-based line and column of a byte offset.
+        // Columns are counted in codepoints.
+        LineCol LineColFor(size_t offset) const;
+        // Get the text of a 1-based line, without the line break
+        std::string_view GetLine(uint32_t lineNo) const;
+        uint32_t GetLineCount() const { return (uint32_t)m_LineStarts.size(); }
 
-        bool IsEOF() const { return m_File.eof(); }
+        // Offset of the first invalid UTF-8 sequence, or npos if the whole file is valid
+        size_t GetInvalidUTF8Offset() const { return m_InvalidUTF8Offset; }
 
     private:
-        std::ifstream m_File;
         const std::string m_FilePath;
-        std::string m_Text;
+        const FileID m_ID;
+        std::string_view m_Text;
+
+        void* m_Mapping = nullptr;
+        size_t m_MappingSize = 0;
+        std::string m_Buffer;
+
+        // Offset of the first byte of every line
+        std::vector<uint32_t> m_LineStarts;
+        size_t m_InvalidUTF8Offset = std::string_view::npos;
+        bool m_IsValid = true;
+
+        bool Map();
+        bool Read();
+        void BuildLineStarts();
+        void ValidateUTF8();
     };
 
     class SourceMap {
     public:
+        // Returns nullptr if the file can't be loaded
         static SourceFile* Load(const std::string& path);
         static SourceFile* Find(const std::string& path);
+        static SourceFile* Get(FileID id) { return s_Files[id].get(); }
 
     private:
+        // Indexed by FileID
         static std::vector<Scope<SourceFile>> s_Files;
+        // Canonical path to FileID
+        static std::unordered_map<std::string, FileID> s_FileIDs;
+
+        static std::string Canonicalize(const std::string& path);
     };
 
 }
\ No newline at end of file
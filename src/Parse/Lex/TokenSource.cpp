@@ -0,0 +1,80 @@
+#include "scarpch.hpp"
+#include "Parse/Lex/TokenSource.hpp"
+
+namespace scar {
+
+    TokenSource::TokenSource(Scope<Lexer> lexer) :
+        m_Lexer(std::move(lexer))
+    {
+        Fill(0);
+        m_Curr = m_Prev = &GetSlot(0);
+    }
+
+    TokenSource::TokenSource(TokenStream tokens) :
+        m_Tokens(std::move(tokens))
+    {
+        SCAR_ASSERT(!m_Tokens.empty() && m_Tokens.back().IsEOF(), "TokenStream must end with EOF!");
+        m_End = m_Tokens.size();
+        Fill(0);
+        m_Curr = m_Prev = &GetSlot(0);
+    }
+
+    TokenSource::TokenSource(const TokenStream& tokens, size_t begin, size_t end) :
+        m_SharedTokens(&tokens),
+        m_Begin(begin),
+        m_End(end)
+    {
+        SCAR_ASSERT(begin <= end && end < tokens.size(), "Token range out of bounds!");
+        Fill(0);
+        m_Curr = m_Prev = &GetSlot(0);
+    }
+
+    void TokenSource::Bump() {
+        if (m_Curr->IsEOF()) {
+            return;
+        }
+        m_Prev = m_Curr;
+        Fill(++m_Head);
+        m_Curr = &GetSlot(m_Head);
+    }
+
+    void TokenSource::Seek(size_t index) {
+        SCAR_ASSERT(!m_Lexer && index > GetIndex() && index <= m_End, "can't seek there!");
+
+        // Only the previous Token has to be kept
+        m_Head = index - m_Begin;
+        m_Tail = m_Head - 1;
+        Fill(m_Head);
+        m_Prev = &GetSlot(m_Head - 1);
+        m_Curr = &GetSlot(m_Head);
+    }
+
+    const Token& TokenSource::Peek(size_t n) {
+        SCAR_ASSERT(n <= MaxLookahead, "peeking too far ahead!");
+
+        // Don't read past EOF
+        size_t index = m_Head;
+        while (index < m_Head + n && !GetSlot(index).IsEOF()) {
+            Fill(++index);
+        }
+        return GetSlot(index);
+    }
+
+    void TokenSource::Fill(size_t index) {
+        while (m_Tail <= index) {
+            if (m_Lexer) {
+                m_Window[m_Tail & (WindowSize - 1)].emplace(m_Lexer->GetNextToken());
+            }
+            else if (m_Begin + m_Tail < m_End) {
+                m_Window[m_Tail & (WindowSize - 1)].emplace(GetStream()[m_Begin + m_Tail]);
+            }
+            else {
+                // End of a range, the EOF sits where the next Token starts
+                const TextSpan& next = GetStream()[m_End].Span;
+                m_Window[m_Tail & (WindowSize - 1)].emplace(Token::EndOfFile, TextSpan(next.File, next.Index, 0));
+            }
+            m_Tail++;
+        }
+    }
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "Parse/Lex/Lexer.hpp"
+#include "Parse/Token.hpp"
+#include <optional>
+
+namespace scar {
+
+    // Feeds Tokens to the Parser, either straight out of a Lexer or from an already lexed TokenStream.
+    // Only a small ring buffer of Tokens is kept alive. When streaming, lexing and parsing overlap
+    // and memory use doesn't grow with the file size.
+    class TokenSource {
+    public:
+        // Number of Tokens past the current one that can be peeked at
+        static constexpr size_t MaxLookahead = 2;
+
+        // Stream Tokens out of the Lexer as the Parser asks for them
+        explicit TokenSource(Scope<Lexer> lexer);
+        // Walk a materialized TokenStream
+        explicit TokenSource(TokenStream tokens);
+        // Walk the Tokens in [begin, end) of a TokenStream owned by someone else, followed by an EOF
+        TokenSource(const TokenStream& tokens, size_t begin, size_t end);
+
+        TokenSource(const TokenSource&) = delete;
+        void operator=(const TokenSource&) = delete;
+
+        // Move to the next Token, EOF is never moved past
+        void Bump();
+
+        const Token& GetCurr() const { return *m_Curr; }
+        // Previous Token, stays valid until the next Bump
+        const Token& GetPrev() const { return *m_Prev; }
+        // Look n Tokens ahead of the current one
+        const Token& Peek(size_t n);
+
+        // Every Token of the stream being walked, nullptr when streaming out of a Lexer
+        const TokenStream* GetTokenStream() const { return m_Lexer ? nullptr : &GetStream(); }
+        // Index of the current Token in GetTokenStream()
+        size_t GetIndex() const { return m_Begin + m_Head; }
+        // Move forward to the Token at index of GetTokenStream(), only when walking a TokenStream
+        void Seek(size_t index);
+
+    private:
+        // Current, previous and lookahead slots, a power of 2 for cheap wrapping
+        static constexpr size_t WindowSize = 4;
+        static_assert(MaxLookahead + 2 <= WindowSize);
+
+        Scope<Lexer> m_Lexer;
+        std::array<std::optional<Token>, WindowSize> m_Window;
+        size_t m_Head = 0; // Index of the current Token
+        size_t m_Tail = 0; // Number of Tokens lexed so far
+
+        TokenStream m_Tokens;
+        const TokenStream* m_SharedTokens = nullptr;
+        size_t m_Begin = 0;
+        size_t m_End = 0;
+
+        const Token* m_Curr = nullptr;
+        const Token* m_Prev = nullptr;
+
+        const Token& GetSlot(size_t index) const { return *m_Window[index & (WindowSize - 1)]; }
+        const TokenStream& GetStream() const { return m_SharedTokens ? *m_SharedTokens : m_Tokens; }
+        // Pull Tokens into the window until it holds the one at index
+        void Fill(size_t index);
+    };
+
+}
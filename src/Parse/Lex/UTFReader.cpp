@@ -1,94 +1,96 @@
 #include "scarpch.hpp"
 #include "Parse/Lex/UTFReader.hpp"
+#include "Core/SIMD.hpp"
 
 namespace scar {
 
     UTFReader::UTFReader(const std::string& path) :
-        m_SourceFile(SourceMap::Load(path))
+        UTFReader(SourceMap::Load(path), 0, std::string_view::npos)
+    {}
+
+    UTFReader::UTFReader(SourceFile* sourceFile, size_t begin, size_t end) :
+        m_SourceFile(sourceFile),
+        m_CurrentPosition((uint32_t)begin),
+        m_NextIndex(begin),
+        m_ReadIndex(begin),
+        m_ASCIIEnd(begin),
+        m_End(std::min(end, sourceFile->GetLength()))
     {
-        auto temp = GetNextCodepoint();
-        std::swap(m_NextCodepoint, temp);
+        // Don't read anything out of a range that isn't valid UTF-8
+        size_t invalidOffset = m_SourceFile->GetInvalidUTF8Offset();
+        if (invalidOffset >= begin && invalidOffset < m_End) {
+            m_HasInvalidUTF8 = true;
+            m_End = begin;
+        }
+
+        m_NextCodepoint = GetNextCodepoint();
         Bump();
     }
 
     void UTFReader::Bump(unsigned int n) {
         for (; n > 0; n--) {
-            m_LastPosition = m_CurrentPosition;
-
-            if (m_CurrentCodepoint == '\n') {
-                m_CurrentPosition.Line++;
-                m_CurrentPosition.Col = 1;
-            }
-            else {
-                m_CurrentPosition.Col++;
-            }
-
             m_CurrentCodepoint = m_NextCodepoint;
-            m_CurrentPosition.Index = m_NextIndex++;
+            m_CurrentPosition.Index = (uint32_t)m_NextIndex;
 
             if (m_CurrentCodepoint.IsEOF()) {
                 m_IsEOF = true;
                 return;
             }
 
+            m_NextIndex = m_ReadIndex;
             m_NextCodepoint = GetNextCodepoint();
         }
     }
 
-    char UTFReader::GetNextByte() {
-        if (IsEOF()) {
-            return '\0';
+    Codepoint UTFReader::GetNextCodepoint() {
+        // Fast path through a run of ASCII
+        if (m_ReadIndex < m_ASCIIEnd) {
+            return Codepoint((uint8_t)GetNextByte());
+        }
+
+        // Find where the next run of ASCII ends
+        if (m_ReadIndex < m_End) {
+            std::string_view rest = m_SourceFile->GetString(m_ReadIndex, m_End - m_ReadIndex);
+            m_ASCIIEnd = m_ReadIndex + simd::FindNonASCII(rest.data(), rest.data() + rest.length());
+            if (m_ReadIndex < m_ASCIIEnd) {
+                return Codepoint((uint8_t)GetNextByte());
+            }
         }
-        return m_SourceFile->GetChar(m_NextIndex);
+
+        return DecodeMultibyte();
     }
 
-    Codepoint UTFReader::GetNextCodepoint() {
+    Codepoint UTFReader::DecodeMultibyte() {
+        // The SourceFile was validated when it was loaded,
+        // so the sequence is known to be well-formed
         uint8_t v1 = GetNextByte();
 
-        if (v1 < 128) {
+        if (v1 < 0x80) {
             return Codepoint(v1);
         }
-        else if ((v1 & 0xC0) == 0x80) { // Invalid
-            return Codepoint(0xFFFE);
-        }
-        else if ((v1 & 0xE0) == 0xC0) { // Two bytes
+        else if (v1 < 0xE0) { // Two bytes
             uint8_t e1 = GetNextByte();
-            if ((e1 & 0xC0) != 0x80) { return { 0xFFFE }; }
-
-            uint32_t outval =
+            return Codepoint(
                 ((v1 & 0x1F) << 6) |
-                ((e1 & 0x3F) << 0);
-            return Codepoint(outval);
+                ((e1 & 0x3F) << 0));
         }
-        else if ((v1 & 0xF0) == 0xE0) { // Three bytes
+        else if (v1 < 0xF0) { // Three bytes
             uint8_t e1 = GetNextByte();
-            if ((e1 & 0xC0) != 0x80) { return { 0xFFFE }; }
             uint8_t e2 = GetNextByte();
-            if ((e2 & 0xC0) != 0x80) { return { 0xFFFE }; }
-
-            uint32_t outval =
+            return Codepoint(
                 ((v1 & 0x0F) << 12) |
                 ((e1 & 0x3F) << 6) |
-                ((e2 & 0x3F) << 0);
-            return Codepoint(outval);
+                ((e2 & 0x3F) << 0));
         }
-        else if ((v1 & 0xF8) == 0xF0) { // Four bytes
+        else { // Four bytes
             uint8_t e1 = GetNextByte();
-            if ((e1 & 0xC0) != 0x80) { return { 0xFFFE }; }
             uint8_t e2 = GetNextByte();
-            if ((e2 & 0xC0) != 0x80) { return { 0xFFFE }; }
             uint8_t e3 = GetNextByte();
-            if ((e3 & 0xC0) != 0x80) { return { 0xFFFE }; }
-
-            uint32_t outval =
+            return Codepoint(
                 ((v1 & 0x07) << 18) |
                 ((e1 & 0x3F) << 12) |
                 ((e2 & 0x3F) << 6) |
-                ((e3 & 0x3F) << 0);
-            return Codepoint(outval);
-        }
-        else {
-            SCAR_ERROR("{}: invalid UTF-8; code is too long", TextSpan(m_SourceFile, m_LastPosition, m_CurrentPosition));
+                ((e3 & 0x3F) << 0));
         }
     }
 
@@ -8,6 +8,8 @@ namespace scar {
     class UTFReader {
     public:
         explicit UTFReader(const std::string& path);
+        // Read only the [begin, end) byte range of an already loaded SourceFile
+        UTFReader(SourceFile* sourceFile, size_t begin, size_t end);
 
         void Bump(unsigned int n = 1);
 
@@ -17,19 +19,30 @@ namespace scar {
         SourceFile* GetSourceFile()             { return m_SourceFile; }
         const SourceFile* GetSourceFile() const { return m_SourceFile; }
         TextPosition GetPosition() const { return m_CurrentPosition; }
+        size_t GetRemainingLength() const { return m_End - m_CurrentPosition.Index; }
         bool IsEOF() const               { return m_IsEOF; }
+        // The range contains invalid UTF-8, it reads as empty
+        bool HasInvalidUTF8() const      { return m_HasInvalidUTF8; }
 
     private:
         SourceFile* m_SourceFile;
-        TextPosition m_LastPosition;
         TextPosition m_CurrentPosition;
         Codepoint m_CurrentCodepoint;
         Codepoint m_NextCodepoint;
-        size_t m_NextIndex = 0;
+        size_t m_NextIndex = 0;  // Start of the next Codepoint
+        size_t m_ReadIndex = 0;  // End of the next Codepoint
+        size_t m_ASCIIEnd = 0;   // Bytes before this are known to be ASCII
+        size_t m_End = 0;        // Bytes from here on read as EOF
         bool m_IsEOF = false;
+        bool m_HasInvalidUTF8 = false;
 
-        char GetNextByte();
+        char GetNextByte() {
+            char c = m_ReadIndex < m_End ? m_SourceFile->GetChar(m_ReadIndex) : '\0';
+            m_ReadIndex++;
+            return c;
+        }
         Codepoint GetNextCodepoint();
+        Codepoint DecodeMultibyte();
     };
 
 }
\ No newline at end of file
@@ -1,37 +1,19 @@
 #include "scarpch.hpp"
 #include "Parse/Parser.hpp"
+#include "Core/Session.hpp"
+#include "Core/ThreadPool.hpp"
 #include "Parse/Lex/Lexer.hpp"
 
-#define SPAN_ERROR(msg, span) SCAR_ERROR("{}: {}", span, msg)
-
 namespace scar {
 
     ///////////////////////////////////////////////////////////////////////////
     ///////////////////////////////////////////////////////////////////////////
     // MISCELANEOUS
 
-    static std::ostream& operator<<(std::ostream& os, const std::vector<Token::TokenType>& types) {
-        os << types[0];
-        for (size_t i = 1; i < types.size(); i++) { os << "," << types[i]; }
-        return os;
-    }
-
-    static std::vector<Token::TokenType> operator+(const std::vector<Token::TokenType>& first, const std::vector<Token::TokenType>& second) {
-        std::vector<Token::TokenType> ret = first;
-        ret.insert(ret.end(), second.begin(), second.end());
-        return ret;
-    }
-
-    static std::vector<Token::TokenType> operator+(const std::vector<Token::TokenType>& vec, Token::TokenType type) {
-        std::vector<Token::TokenType> ret = vec;
-        ret.push_back(type);
-        return ret;
-    }
-
-    static std::vector<Token::TokenType> s_DeclStartTokens = {
+    static constexpr TokenSet s_DeclStartTokens = {
         Token::Func,
     };
-    static std::vector<Token::TokenType> s_StmtStartTokens = {
+    static constexpr TokenSet s_StmtStartTokens = {
         Token::If,
         Token::Else,
         Token::For,
@@ -43,71 +25,102 @@ namespace scar {
         Token::Return,
         Token::Semi,
     };
+    // Tokens an expression can start with, besides prefix operators
+    static constexpr TokenSet s_AtomStartTokens = {
+        Token::Ident,
+        Token::Var,
+        Token::True, Token::False,
+        Token::LitInt, Token::LitFloat, Token::LitString,
+    };
+    static constexpr TokenSet s_TypeTokens = {
+        Token::Bool,
+        Token::I8, Token::I16, Token::I32, Token::I64,
+        Token::U8, Token::U16, Token::U32, Token::U64,
+        Token::F32, Token::F64,
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////////////////////////////////////
+    // OPERATORS
 
     struct OperatorInfo {
-        Token::TokenType TokenType = Token::Invalid;
-        unsigned int Precedence = 0;
-        enum Assoc { Left, Right } Associativity = Assoc::Left;
+        enum Fixity : uint8_t { Prefix, Suffix, Binary };
+        enum Assoc : uint8_t { Left, Right };
 
-        OperatorInfo() = default;
-        OperatorInfo(Token::TokenType tokenType, unsigned int prec, Assoc assoc) :
-            TokenType(tokenType),
-            Precedence(prec),
-            Associativity(assoc) {
+        Token::TokenType TokenType = Token::Invalid;
+        Fixity Fix = Fixity::Binary;
+        // Zero for tokens that aren't an operator
+        uint8_t Precedence = 0;
+        Assoc Associativity = Assoc::Left;
+
+        constexpr bool IsValid() const { return Precedence != 0; }
+        // Precedence of the operand to the right of the operator
+        constexpr unsigned int GetRhsPrecedence() const {
+            return Associativity == Assoc::Left ? Precedence + 1u : Precedence;
         }
+    };
 
-        bool IsCast() { return TokenType == Token::As; }
+    // Every operator of the language, the lookup tables below are generated from this list.
+    //
+    // prefix_op : + - ! ~ ++ --
+    // suffix_op : ++ -- as
+    // binary_op : + - * / %
+    //           | && || & | ^
+    //           | == != > >= < <=
+    //           | =
+    static constexpr OperatorInfo s_Operators[] = {
+        { Token::PlusPlus,   OperatorInfo::Suffix, 13, OperatorInfo::Left  },
+        { Token::MinusMinus, OperatorInfo::Suffix, 13, OperatorInfo::Left  },
+
+        { Token::PlusPlus,   OperatorInfo::Prefix, 12, OperatorInfo::Right },
+        { Token::MinusMinus, OperatorInfo::Prefix, 12, OperatorInfo::Right },
+        { Token::Plus,       OperatorInfo::Prefix, 12, OperatorInfo::Right },
+        { Token::Minus,      OperatorInfo::Prefix, 12, OperatorInfo::Right },
+        { Token::Not,        OperatorInfo::Prefix, 12, OperatorInfo::Right },
+        { Token::BitNot,     OperatorInfo::Prefix, 12, OperatorInfo::Right },
+
+        { Token::As,         OperatorInfo::Suffix, 11, OperatorInfo::Left  },
+
+        { Token::Star,       OperatorInfo::Binary, 10, OperatorInfo::Left  },
+        { Token::Slash,      OperatorInfo::Binary, 10, OperatorInfo::Left  },
+        { Token::Percent,    OperatorInfo::Binary, 10, OperatorInfo::Left  },
+        { Token::Plus,       OperatorInfo::Binary, 9,  OperatorInfo::Left  },
+        { Token::Minus,      OperatorInfo::Binary, 9,  OperatorInfo::Left  },
+        { Token::Greater,    OperatorInfo::Binary, 8,  OperatorInfo::Left  },
+        { Token::GreaterEq,  OperatorInfo::Binary, 8,  OperatorInfo::Left  },
+        { Token::Lesser,     OperatorInfo::Binary, 8,  OperatorInfo::Left  },
+        { Token::LesserEq,   OperatorInfo::Binary, 8,  OperatorInfo::Left  },
+        { Token::Eq,         OperatorInfo::Binary, 7,  OperatorInfo::Left  },
+        { Token::NotEq,      OperatorInfo::Binary, 7,  OperatorInfo::Left  },
+        { Token::BitAnd,     OperatorInfo::Binary, 6,  OperatorInfo::Left  },
+        { Token::BitXOr,     OperatorInfo::Binary, 5,  OperatorInfo::Left  },
+        { Token::BitOr,      OperatorInfo::Binary, 4,  OperatorInfo::Left  },
+        { Token::LogicAnd,   OperatorInfo::Binary, 3,  OperatorInfo::Left  },
+        { Token::LogicOr,    OperatorInfo::Binary, 2,  OperatorInfo::Left  },
+        { Token::Assign,     OperatorInfo::Binary, 1,  OperatorInfo::Right },
     };
 
-    static OperatorInfo GetPrefixOperatorInfo(Token::TokenType type) {
-        switch (type) {
-        case Token::PlusPlus:   return OperatorInfo(type, 12, OperatorInfo::Right);
-        case Token::MinusMinus: return OperatorInfo(type, 12, OperatorInfo::Right);
-        case Token::Plus:   return OperatorInfo(type, 12, OperatorInfo::Right);
-        case Token::Minus:  return OperatorInfo(type, 12, OperatorInfo::Right);
-        case Token::Not:    return OperatorInfo(type, 12, OperatorInfo::Right);
-        case Token::BitNot: return OperatorInfo(type, 12, OperatorInfo::Right);
-        default:
-            SCAR_BUG("missing prefix OperatorInfo for Token::Type {}", (int)type);
-            return OperatorInfo();
-        }
-    }
-    static OperatorInfo GetSuffixOperatorInfo(Token::TokenType type) {
-        switch (type) {
-        case Token::PlusPlus:   return OperatorInfo(Token::PlusPlus,   13, OperatorInfo::Left);
-        case Token::MinusMinus: return OperatorInfo(Token::MinusMinus, 13, OperatorInfo::Left);
-        case Token::As:         return OperatorInfo(Token::As, 11, OperatorInfo::Left);
-        default:
-            SCAR_BUG("missing suffix OperatorInfo for Token::Type {}", (int)type);
-            return OperatorInfo();
-        }
-    }
-    static OperatorInfo GetBinaryOperatorInfo(Token::TokenType type) {
-        switch (type) {
-        case Token::Dot:       return OperatorInfo(type, 13, OperatorInfo::Left);
-        case Token::Star:      return OperatorInfo(type, 10, OperatorInfo::Left);
-        case Token::Slash:     return OperatorInfo(type, 10, OperatorInfo::Left);
-        case Token::Percent:   return OperatorInfo(type, 10, OperatorInfo::Left);
-        case Token::Plus:      return OperatorInfo(type, 9, OperatorInfo::Left);
-        case Token::Minus:     return OperatorInfo(type, 9, OperatorInfo::Left);
-        case Token::Greater:   return OperatorInfo(type, 8, OperatorInfo::Left);
-        case Token::GreaterEq: return OperatorInfo(type, 8, OperatorInfo::Left);
-        case Token::Lesser:    return OperatorInfo(type, 8, OperatorInfo::Left);
-        case Token::LesserEq:  return OperatorInfo(type, 8, OperatorInfo::Left);
-        case Token::Eq:        return OperatorInfo(type, 7, OperatorInfo::Left);
-        case Token::NotEq:     return OperatorInfo(type, 7, OperatorInfo::Left);
-        case Token::BitAnd:    return OperatorInfo(type, 6, OperatorInfo::Left);
-        case Token::BitXOr:    return OperatorInfo(type, 5, OperatorInfo::Left);
-        case Token::BitOr:     return OperatorInfo(type, 4, OperatorInfo::Left);
-        case Token::LogicAnd:  return OperatorInfo(type, 3, OperatorInfo::Left);
-        case Token::LogicOr:   return OperatorInfo(type, 2, OperatorInfo::Left);
-        case Token::Assign:    return OperatorInfo(type, 1, OperatorInfo::Right);
-        default:
-            SCAR_BUG("missing binary OperatorInfo for Token::Type {}", (int)type);
-            return OperatorInfo();
+    using OperatorTable = std::array<OperatorInfo, Token::EndOfFile + 1>;
+
+    // Index the operators of one fixity by their token type
+    static constexpr OperatorTable MakeOperatorTable(OperatorInfo::Fixity fixity) {
+        OperatorTable table{};
+        for (const OperatorInfo& op : s_Operators) {
+            if (op.Fix == fixity) {
+                table[op.TokenType] = op;
+            }
         }
+        return table;
     }
 
+    static constexpr OperatorTable s_PrefixOperators = MakeOperatorTable(OperatorInfo::Prefix);
+    static constexpr OperatorTable s_SuffixOperators = MakeOperatorTable(OperatorInfo::Suffix);
+    static constexpr OperatorTable s_BinaryOperators = MakeOperatorTable(OperatorInfo::Binary);
+
+    ///////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////////////////////////////////////
+    // AST CONVERSIONS
+
     ast::TypeInfo ASTType(Token::TokenType tokenType) {
         return (ast::TypeInfo)tokenType;
     }
@@ -128,69 +141,191 @@ namespace scar {
     ///////////////////////////////////////////////////////////////////////////
     // PARSER
 
-    Parser::Parser(const std::string& path) {
-        Lexer lexer(path);
-        m_TokenStream = lexer.Lex();
-        m_Token = m_TokenStream.begin();
+    static TokenSource MakeTokenSource(const std::string& path) {
+        if (Session::GetProperties().ParallelLex) {
+            return TokenSource(Lexer::LexParallel(path, Session::GetThreadPool()));
+        }
+        // Parallel parsing needs every Token up front
+        if (Session::GetProperties().StreamTokens && !Session::GetProperties().ParallelParse) {
+            return TokenSource(MakeScope<Lexer>(path));
+        }
+        return TokenSource(Lexer(path).Lex());
     }
 
+    Parser::Parser(const std::string& path, ast::ASTContext& context) :
+        m_Context(context),
+        m_Diagnostics(Session::GetDiagnostics()),
+        m_Source(MakeTokenSource(path)),
+        m_Token(&m_Source.GetCurr())
+    {}
+
+    Parser::Parser(const TokenStream& tokens, size_t begin, size_t end, ast::ASTContext& context, DiagnosticEngine& diagnostics) :
+        m_Context(context),
+        m_Diagnostics(diagnostics),
+        m_Source(tokens, begin, end),
+        m_Token(&m_Source.GetCurr())
+    {}
+
     void Parser::Bump() {
-        m_Token++;
+        m_Source.Bump();
+        m_Token = &m_Source.GetCurr();
     }
 
-    bool Parser::Match(const std::vector<Token::TokenType>& expected) const {
-        for (auto type : expected) {
-            if (*m_Token == type) {
-                return true;
-            }
-        }
-        return false;
+    bool Parser::Match(const TokenSet& expected) const {
+        return expected.Contains(m_Token->Type);
     }
 
-    Token& Parser::Expect(const std::vector<Token::TokenType>& expected) {
+    const Token* Parser::Expect(const TokenSet& expected) {
         if (!Match(expected)) {
-            SPAN_ERROR(FMT("unexpected token: {} where {} was expected", *m_Token, expected), m_Token->Span);
+            m_Diagnostics.Report(m_Token->Span, DiagID::UnexpectedToken, *m_Token, expected);
+            return nullptr;
         }
         Bump();
-        return *(m_Token - 1);
+        return &m_Source.GetPrev();
     }
 
-    void Parser::Synchronize(const std::vector<Token::TokenType>& delims) {
-        SCAR_TRACE("synchronizing");
-        while (!Match(delims)) {
+    void Parser::Synchronize(const TokenSet& delims) {
+        while (!Match(delims) && !m_Token->IsEOF()) {
             Bump();
         }
     }
 
-    Ref<ast::Module> Parser::Parse() {
+    ast::Module* Parser::Parse() {
+        const TokenStream* tokens = m_Source.GetTokenStream();
+        if (Session::GetProperties().ParallelParse && tokens) {
+            if (ast::Module* module = ParseParallel(*tokens)) {
+                return module;
+            }
+        }
+
         TextPosition start;
-        std::vector<Ref<ast::Stmt>> items;
-        while (*m_Token != Token::EndOfFile) {
+        std::vector<ast::Stmt*> items;
+        while (*m_Token != Token::EndOfFile && !m_Diagnostics.HasReachedErrorLimit()) {
             if (auto item = Global()) {
                 items.push_back(item);
             }
         }
-        return MakeRef<ast::Module>(items, GetSpanFrom(start));
+        return m_Context.New<ast::Module>(m_Context.NewList(items), GetSpanFrom(start));
+    }
+
+    // Find where every top level item starts by matching braces, without parsing anything.
+    // Returns false unless the file is a well formed list of functions and prototypes.
+    static bool SkimItems(const TokenStream& tokens, std::vector<size_t>& itemStarts) {
+        const uint8_t* types = tokens.GetTypes();
+        size_t count = tokens.size() - 1;
+
+        size_t i = 0;
+        while (i < count) {
+            if (types[i] != Token::Func) {
+                return false;
+            }
+            itemStarts.push_back(i);
+
+            // Items end with a prototype's ; or the body's closing brace
+            uint32_t depth = 0;
+            bool closed = false;
+            for (i++; i < count && !closed; i++) {
+                if (types[i] == Token::LBrace) {
+                    depth++;
+                }
+                else if (types[i] == Token::RBrace) {
+                    if (depth == 0) {
+                        return false;
+                    }
+                    closed = --depth == 0;
+                }
+                else if (types[i] == Token::Semi) {
+                    closed = depth == 0;
+                }
+            }
+            if (!closed) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    ast::Module* Parser::ParseParallel(const TokenStream& tokens) {
+        ThreadPool& pool = Session::GetThreadPool();
+        if (pool.GetThreadCount() <= 1) {
+            return nullptr;
+        }
+
+        std::vector<size_t> itemStarts;
+        if (!SkimItems(tokens, itemStarts)) {
+            return nullptr;
+        }
+
+        size_t eofIndex = tokens.size() - 1;
+        size_t batchCount = std::min(pool.GetThreadCount(), itemStarts.size());
+        if (batchCount <= 1) {
+            return nullptr;
+        }
+
+        // Split the items into one batch of about the same number of Tokens per thread
+        std::vector<size_t> boundaries;
+        size_t batchSize = eofIndex / batchCount;
+        for (size_t start : itemStarts) {
+            if (boundaries.empty() || start - boundaries.back() >= batchSize) {
+                boundaries.push_back(start);
+            }
+        }
+        boundaries.push_back(eofIndex);
+        batchCount = boundaries.size() - 1;
+
+        // Every batch gets its own context so threads never share an allocator
+        std::vector<ast::ASTContext> contexts(batchCount);
+        std::vector<std::vector<ast::Stmt*>> batchItems(batchCount);
+        std::vector<uint32_t> skippedBodies(batchCount, 0);
+        std::vector<uint8_t> failed(batchCount, false);
+        pool.ParallelFor(batchCount, [&](size_t i) {
+            // Batches give up at their first error
+            DiagnosticEngine diagnostics;
+            Parser parser(tokens, boundaries[i], boundaries[i + 1], contexts[i], diagnostics);
+            // Skipped bodies are parsed on demand, long after the batch's Parser is gone
+            parser.m_BodyParser = this;
+            while (!parser.m_Token->IsEOF() && !diagnostics.HasErrors()) {
+                batchItems[i].push_back(parser.Function());
+            }
+            failed[i] = diagnostics.HasErrors();
+            skippedBodies[i] = parser.m_SkippedBodies;
+        });
+
+        // Errors are reported by the sequential parse, so they come out in order and recover the same way
+        if (std::find(failed.begin(), failed.end(), (uint8_t)true) != failed.end()) {
+            return nullptr;
+        }
+
+        std::vector<ast::Stmt*> items;
+        items.reserve(itemStarts.size());
+        for (size_t i = 0; i < batchCount; i++) {
+            m_SkippedBodies += skippedBodies[i];
+            m_Context.Merge(contexts[i]);
+            items.insert(items.end(), batchItems[i].begin(), batchItems[i].end());
+        }
+
+        Token eof = tokens[eofIndex];
+        return m_Context.New<ast::Module>(m_Context.NewList(items), TextSpan(eof.Span.File, 0, eof.Span.Index));
     }
 
     ///////////////////////////////////////////////////////////////////////////
     ///////////////////////////////////////////////////////////////////////////
     // TYPE
 
-    Token& Parser::ExpectTypeToken() {
-        return Expect({ Token::Bool,
-            Token::I8, Token::I16, Token::I32, Token::I64,
-            Token::U8, Token::U16, Token::U32, Token::U64,
-            Token::F32, Token::F64 });
+    const Token* Parser::ExpectTypeToken() {
+        return Expect(s_TypeTokens);
     }
 
     // type : BOOL
     //      | I8 I16 I32 I64
     //      | U8 U16 U32 U64
     //      | F32 F64
-    Ref<ast::Type> Parser::Type() {
-        Token& token = ExpectTypeToken();
-        return MakeRef<ast::Type>((ast::TypeInfo)token.Type, token.Span);
+    ast::Type* Parser::Type() {
+        const Token* token = ExpectTypeToken();
+        if (!token) {
+            return nullptr;
+        }
+        return m_Context.New<ast::Type>((ast::TypeInfo)token->Type, token->Span);
     }
 
     ///////////////////////////////////////////////////////////////////////////
@@ -198,19 +333,28 @@ namespace scar {
     // SUPPORT
 
     // ident : IDENT
-    ast::Ident Parser::Ident() {
-        Token& token = Expect({ Token::Ident });
-        return ast::Ident(token.GetName(), token.Span);
+    std::optional<ast::Ident> Parser::Ident() {
+        const Token* token = Expect({ Token::Ident });
+        if (!token) {
+            return std::nullopt;
+        }
+        return ast::Ident(token->GetName(), token->Span);
     }
 
     // arg : ident type
-    ast::Arg Parser::Arg() {
+    std::optional<ast::Arg> Parser::Arg() {
         TextPosition start = m_Token->GetTextPos();
 
-        ast::Ident ident = Ident();
-        Ref<ast::Type> type = Type();
+        std::optional<ast::Ident> ident = Ident();
+        if (!ident) {
+            return std::nullopt;
+        }
+        ast::Type* type = Type();
+        if (!type) {
+            return std::nullopt;
+        }
 
-        return ast::Arg(ident, type, GetSpanFrom(start));
+        return ast::Arg(*ident, type, GetSpanFrom(start));
     }
 
     ///////////////////////////////////////////////////////////////////////////
@@ -218,67 +362,95 @@ namespace scar {
     // DECLARATIONS
 
     // global : function
-    Ref<ast::Stmt> Parser::Global() {
-        try {
-            switch (m_Token->Type) {
-            case Token::Func: return Function();
-            default:
-                SPAN_ERROR("expected a declaration", m_Token->Span);
-                break;
-            }
-        }
-        catch (CompilerError& e) {
-            e.OnCatch();
-            Synchronize({ s_DeclStartTokens });
-            return nullptr;
+    ast::Stmt* Parser::Global() {
+        ast::Stmt* item = nullptr;
+        switch (m_Token->Type) {
+        case Token::Func:
+            item = Function();
+            break;
+        default:
+            m_Diagnostics.Report(m_Token->Span, DiagID::ExpectedDeclaration);
+            break;
         }
 
-        return nullptr;
+        // Skip to the next declaration after an error
+        if (!item) {
+            Synchronize(s_DeclStartTokens);
+        }
+        return item;
     }
 
     // function : prototype block
     //          | prototype ;
-    Ref<ast::Stmt> Parser::Function() {
+    ast::Stmt* Parser::Function() {
         TextPosition start = m_Token->GetTextPos();
 
-        Ref<ast::FunctionPrototype> prototype = FunctionPrototype();
+        ast::FunctionPrototype* prototype = FunctionPrototype();
+        if (!prototype) {
+            return nullptr;
+        }
 
         if (*m_Token == Token::Semi) {
             Bump();
             return prototype;
         }
 
-        Ref<ast::Block> block = Block();
+        if (!Session::GetProperties().EagerParse) {
+            std::optional<ast::TokenRange> bodyTokens = SkipBlock();
+            if (!bodyTokens) {
+                return nullptr;
+            }
+            m_SkippedBodies++;
+            return m_Context.New<ast::Function>(prototype, m_BodyParser, *bodyTokens, GetSpanFrom(start));
+        }
+
+        ast::Block* block = Block();
+        if (!block) {
+            return nullptr;
+        }
 
-        return MakeRef<ast::Function>(prototype, block, GetSpanFrom(start));
+        return m_Context.New<ast::Function>(prototype, block, GetSpanFrom(start));
     }
 
     // prototype : FUNC ident ( arg* ) -> type
     //           | FUNC ident ( arg* )
-    Ref<ast::FunctionPrototype> Parser::FunctionPrototype() {
+    ast::FunctionPrototype* Parser::FunctionPrototype() {
         TextPosition start = m_Token->GetTextPos();
 
-        Expect({ Token::Func });
+        if (!Expect({ Token::Func })) {
+            return nullptr;
+        }
 
-        ast::Ident ident = Ident();
+        std::optional<ast::Ident> ident = Ident();
+        if (!ident || !Expect({ Token::LParen })) {
+            return nullptr;
+        }
 
-        Expect({ Token::LParen });
         std::vector<ast::Arg> args;
         while (*m_Token != Token::RParen) {
-            args.push_back(Arg());
+            std::optional<ast::Arg> arg = Arg();
+            if (!arg) {
+                return nullptr;
+            }
+            args.push_back(*arg);
+        }
+        if (!Expect({ Token::RParen })) {
+            return nullptr;
         }
-        Expect({ Token::RParen });
 
-        Ref<ast::Type> retType;
+        ast::Type* retType;
         if (*m_Token != Token::RArrow) {
-            retType = MakeRef<ast::Type>(ast::TypeInfo::Void, ident.GetSpan());
+            retType = m_Context.New<ast::Type>(ast::TypeInfo::Void, ident->GetSpan());
         }
         else {
             Expect({ Token::RArrow });
             retType = Type();
+            if (!retType) {
+                return nullptr;
+            }
         }
 
-        return MakeRef<ast::FunctionPrototype>(ident, args, retType, GetSpanFrom(start));
+        return m_Context.New<ast::FunctionPrototype>(*ident, m_Context.NewList(args), retType, GetSpanFrom(start));
     }
 
     ///////////////////////////////////////////////////////////////////////////
@@ -293,146 +465,261 @@ namespace scar {
     //      | return
     //      | expr ;
     //      | ;
-    Ref<ast::Stmt> Parser::Stmt() {
-        try {
-            switch (m_Token->Type) {
-            case Token::If:       return Branch();
-            case Token::For:      return ForLoop();
-            case Token::While:    return WhileLoop();
-            case Token::Loop:     return Loop();
-            case Token::Continue: return Continue();
-            case Token::Break:    return Break();
-            case Token::Return:   return Return();
-            case Token::Semi:     Bump(); return nullptr;
-            default:
-            {
-                TextPosition start = m_Token->GetTextPos();
-
-                if (Ref<ast::Expr> expr = TryExpr()) {
-                    Expect({ Token::Semi });
-                    return expr;
-                }
+    ast::Stmt* Parser::Stmt() {
+        ast::Stmt* stmt = nullptr;
+        switch (m_Token->Type) {
+        case Token::If:       stmt = Branch(); break;
+        case Token::For:      stmt = ForLoop(); break;
+        case Token::While:    stmt = WhileLoop(); break;
+        case Token::Loop:     stmt = Loop(); break;
+        case Token::Continue: stmt = Continue(); break;
+        case Token::Break:    stmt = Break(); break;
+        case Token::Return:   stmt = Return(); break;
+        case Token::Semi:     Bump(); return nullptr;
+        default:
+        {
+            TextPosition start = m_Token->GetTextPos();
 
-                SPAN_ERROR("expected a statement", GetSpanFrom(start));
+            ast::Expr* expr;
+            if (!TryExpr(expr)) {
                 break;
             }
+            if (expr) {
+                stmt = Expect({ Token::Semi }) ? expr : nullptr;
+                break;
             }
+
+            m_Diagnostics.Report(GetSpanFrom(start), DiagID::ExpectedStatement);
+            break;
         }
-        catch (CompilerError& e) {
-            e.OnCatch();
-            Synchronize({ s_StmtStartTokens });
-            return nullptr;
         }
 
-        return nullptr;
+        // Skip to the next statement after an error
+        if (!stmt) {
+            Synchronize(s_StmtStartTokens);
+        }
+        return stmt;
     }
 
     // branch : IF ( expr ) block ELSE block
     //        | IF ( expr ) block
-    Ref<ast::Branch> Parser::Branch() {
+    ast::Branch* Parser::Branch() {
         TextPosition start = m_Token->GetTextPos();
 
-        Expect({ Token::If });
-
-        Expect({ Token::LParen });
-        Ref<ast::Expr> cond = Expr();
-        Expect({ Token::RParen });
-
-        Ref<ast::Block> trueBlock = Block();
+        if (!Expect({ Token::If }) || !Expect({ Token::LParen })) {
+            return nullptr;
+        }
+        ast::Expr* cond = Expr();
+        if (!cond || !Expect({ Token::RParen })) {
+            return nullptr;
+        }
 
-        Expect({ Token::Else });
+        ast::Block* trueBlock = Block();
+        if (!trueBlock || !Expect({ Token::Else })) {
+            return nullptr;
+        }
 
-        Ref<ast::Block> falseBlock = Block();
+        ast::Block* falseBlock = Block();
+        if (!falseBlock) {
+            return nullptr;
+        }
 
-        return MakeRef<ast::Branch>(cond, trueBlock, falseBlock, GetSpanFrom(start));
+        return m_Context.New<ast::Branch>(cond, trueBlock, falseBlock, GetSpanFrom(start));
     }
 
     // for_loop : FOR ( try_expr ; expr ; try_expr ) block
-    Ref<ast::ForLoop> Parser::ForLoop() {
+    ast::ForLoop* Parser::ForLoop() {
         TextPosition start = m_Token->GetTextPos();
 
-        Expect({ Token::For });
-
-        Expect({ Token::LParen });
-        Ref<ast::Expr> init = TryExpr();
-        Expect({ Token::Semi });
-        Ref<ast::Expr> cond = Expr();
-        Expect({ Token::Semi });
-        Ref<ast::Expr> update = TryExpr();
-        Expect({ Token::RParen });
+        if (!Expect({ Token::For }) || !Expect({ Token::LParen })) {
+            return nullptr;
+        }
+        ast::Expr* init;
+        if (!TryExpr(init) || !Expect({ Token::Semi })) {
+            return nullptr;
+        }
+        ast::Expr* cond = Expr();
+        if (!cond || !Expect({ Token::Semi })) {
+            return nullptr;
+        }
+        ast::Expr* update;
+        if (!TryExpr(update) || !Expect({ Token::RParen })) {
+            return nullptr;
+        }
 
-        Ref<ast::Block> block = Block();
+        ast::Block* block = Block();
+        if (!block) {
+            return nullptr;
+        }
 
-        return MakeRef<ast::ForLoop>(init, cond, update, block, GetSpanFrom(start));
+        return m_Context.New<ast::ForLoop>(init, cond, update, block, GetSpanFrom(start));
     }
 
     // while_loop : WHILE ( expr ) block
-    Ref<ast::WhileLoop> Parser::WhileLoop() {
+    ast::WhileLoop* Parser::WhileLoop() {
         TextPosition start = m_Token->GetTextPos();
 
-        Expect({ Token::While });
-
-        Expect({ Token::LParen });
-        Ref<ast::Expr> cond = Expr();
-        Expect({ Token::RParen });
+        if (!Expect({ Token::While }) || !Expect({ Token::LParen })) {
+            return nullptr;
+        }
+        ast::Expr* cond = Expr();
+        if (!cond || !Expect({ Token::RParen })) {
+            return nullptr;
+        }
 
-        Ref<ast::Block> block = Block();
+        ast::Block* block = Block();
+        if (!block) {
+            return nullptr;
+        }
 
-        return MakeRef<ast::WhileLoop>(cond, block, GetSpanFrom(start));
+        return m_Context.New<ast::WhileLoop>(cond, block, GetSpanFrom(start));
     }
 
     // loop : LOOP block
-    Ref<ast::WhileLoop> Parser::Loop() {
+    ast::WhileLoop* Parser::Loop() {
         TextPosition start = m_Token->GetTextPos();
 
-        Expect({ Token::Loop });
-        Ref<ast::LiteralBool> cond = MakeRef<ast::LiteralBool>(true, m_Token->Span);
-        Ref<ast::Block> block = Block();
+        if (!Expect({ Token::Loop })) {
+            return nullptr;
+        }
+        ast::LiteralBool* cond = m_Context.New<ast::LiteralBool>(true, m_Token->Span);
+        ast::Block* block = Block();
+        if (!block) {
+            return nullptr;
+        }
 
-        return MakeRef<ast::WhileLoop>(cond, block, GetSpanFrom(start));
+        return m_Context.New<ast::WhileLoop>(cond, block, GetSpanFrom(start));
     }
 
     // block : { stmt* }
-    Ref<ast::Block> Parser::Block() {
+    ast::Block* Parser::Block() {
         TextPosition start = m_Token->GetTextPos();
 
-        Expect({ Token::LBrace });
-        std::vector<Ref<ast::Stmt>> items;
-        while (*m_Token != Token::RBrace) {
+        if (!Expect({ Token::LBrace })) {
+            return nullptr;
+        }
+        std::vector<ast::Stmt*> items;
+        while (!Match({ Token::RBrace, Token::EndOfFile }) && !m_Diagnostics.HasReachedErrorLimit()) {
             if (auto item = Stmt()) {
                 items.push_back(item);
             }
         }
-        Expect({ Token::RBrace });
+        if (!Expect({ Token::RBrace })) {
+            return nullptr;
+        }
 
-        return MakeRef<ast::Block>(items, GetSpanFrom(start));
+        return m_Context.New<ast::Block>(m_Context.NewList(items), GetSpanFrom(start));
+    }
+
+    std::optional<ast::TokenRange> Parser::SkipBlock() {
+        ast::TokenRange range;
+
+        // Match braces on the types alone when every Token is at hand
+        if (const TokenStream* tokens = m_Source.GetTokenStream()) {
+            range.Begin = (uint32_t)m_Source.GetIndex();
+            if (!Expect({ Token::LBrace })) {
+                return std::nullopt;
+            }
+
+            const uint8_t* types = tokens->GetTypes();
+            size_t index = m_Source.GetIndex();
+            uint32_t depth = 1;
+            for (; types[index] != Token::EndOfFile; index++) {
+                if (types[index] == Token::LBrace) {
+                    depth++;
+                }
+                else if (types[index] == Token::RBrace && --depth == 0) {
+                    break;
+                }
+            }
+
+            // Fail the same way Block() would
+            if (index > m_Source.GetIndex()) {
+                m_Source.Seek(index);
+                m_Token = &m_Source.GetCurr();
+            }
+            if (!Expect({ Token::RBrace })) {
+                return std::nullopt;
+            }
+
+            range.End = (uint32_t)m_Source.GetIndex();
+            return range;
+        }
+
+        // Streamed Tokens are gone once they're bumped past, so they're kept aside
+        range.Begin = (uint32_t)m_SkippedTokens.size();
+
+        if (!Expect({ Token::LBrace })) {
+            return std::nullopt;
+        }
+        m_SkippedTokens.push_back(m_Source.GetPrev());
+
+        uint32_t depth = 1;
+        while (depth > 0) {
+            // Fail the same way Block() would
+            if (m_Token->IsEOF()) {
+                Expect({ Token::RBrace });
+                return std::nullopt;
+            }
+            if (*m_Token == Token::LBrace) {
+                depth++;
+            }
+            else if (*m_Token == Token::RBrace) {
+                depth--;
+            }
+            m_SkippedTokens.push_back(*m_Token);
+            Bump();
+        }
+
+        range.End = (uint32_t)m_SkippedTokens.size();
+        // Marks where the body's EOF goes when it's parsed
+        m_SkippedTokens.push_back(Token(Token::EndOfFile, TextSpan(m_Token->Span.File, m_Token->Span.Index, 0)));
+        return range;
+    }
+
+    ast::Block* Parser::ParseBody(ast::TokenRange tokens) {
+        m_ParsedBodies++;
+
+        const TokenStream* stream = m_Source.GetTokenStream();
+        Parser parser(stream ? *stream : m_SkippedTokens, tokens.Begin, tokens.End, m_Context, m_Diagnostics);
+        if (ast::Block* block = parser.Block()) {
+            return block;
+        }
+        // Leave an empty body, compilation fails anyway
+        return m_Context.New<ast::Block>(ast::List<ast::Stmt*>(), parser.m_Token->Span);
     }
 
     // continue : CONTINUE ;
-    Ref<ast::Continue> Parser::Continue() {
+    ast::Continue* Parser::Continue() {
         TextPosition start = m_Token->GetTextPos();
-        Expect({ Token::Continue });
-        Expect({ Token::Semi });
-        return MakeRef<ast::Continue>(GetSpanFrom(start));
+        if (!Expect({ Token::Continue }) || !Expect({ Token::Semi })) {
+            return nullptr;
+        }
+        return m_Context.New<ast::Continue>(GetSpanFrom(start));
     }
 
     // break : BREAK ;
-    Ref<ast::Break> Parser::Break() {
+    ast::Break* Parser::Break() {
         TextPosition start = m_Token->GetTextPos();
-        Expect({ Token::Break });
-        Expect({ Token::Semi });
-        return MakeRef<ast::Break>(GetSpanFrom(start));
+        if (!Expect({ Token::Break }) || !Expect({ Token::Semi })) {
+            return nullptr;
+        }
+        return m_Context.New<ast::Break>(GetSpanFrom(start));
     }
 
     // return : RETURN try_expr ;
-    Ref<ast::Return> Parser::Return() {
+    ast::Return* Parser::Return() {
         TextPosition start = m_Token->GetTextPos();
 
-        Expect({ Token::Return });
-        Ref<ast::Expr> value = TryExpr();
-        Expect({ Token::Semi });
+        if (!Expect({ Token::Return })) {
+            return nullptr;
+        }
+        ast::Expr* value;
+        if (!TryExpr(value) || !Expect({ Token::Semi })) {
+            return nullptr;
+        }
 
-        return MakeRef<ast::Return>(value, GetSpanFrom(start));
+        return m_Context.New<ast::Return>(value, GetSpanFrom(start));
     }
 
     ///////////////////////////////////////////////////////////////////////////
@@ -440,35 +727,41 @@ namespace scar {
     // EXPRESSIONS
 
     // try_expr : expr?
-    Ref<ast::Expr> Parser::TryExpr() {
-        return Expr(1, true);
+    bool Parser::TryExpr(ast::Expr*& expr) {
+        expr = nullptr;
+        if (!IsPrefixOperator() && !Match(s_AtomStartTokens)) {
+            return true;
+        }
+        expr = Expr();
+        return expr != nullptr;
     }
 
     // expr : atom binary_op expr
     //      | atom
-    Ref<ast::Expr> Parser::Expr(unsigned int prec, bool allowEmpty) {
+    ast::Expr* Parser::Expr(unsigned int prec) {
         TextPosition start = m_Token->GetTextPos();
 
         // Parse left side of expression
-        Ref<ast::Expr> lhs = ExprAtom(prec, allowEmpty);
-        if (!lhs && allowEmpty) {
+        ast::Expr* lhs = ExprAtom(prec);
+        if (!lhs) {
             return nullptr;
         }
 
-        while (IsBinaryOperator()) {
-            OperatorInfo opInfo = GetBinaryOperatorInfo(m_Token->Type);
-            if (opInfo.Precedence < prec) {
+        while (true) {
+            const OperatorInfo& opInfo = s_BinaryOperators[m_Token->Type];
+            if (!opInfo.IsValid() || opInfo.Precedence < prec) {
                 break;
             }
             Bump();
 
             // Parse right side of expression
-            Ref<ast::Expr> rhs = Expr(opInfo.Associativity == OperatorInfo::Left ?
-                                      opInfo.Precedence + 1 :
-                                      opInfo.Precedence);
+            ast::Expr* rhs = Expr(opInfo.GetRhsPrecedence());
+            if (!rhs) {
+                return nullptr;
+            }
 
             // Set LHS to complete expression
-            lhs = MakeRef<ast::BinaryOperator>(ASTBinaryOp(opInfo.TokenType), lhs, rhs, GetSpanFrom(start));
+            lhs = m_Context.New<ast::BinaryOperator>(ASTBinaryOp(opInfo.TokenType), lhs, rhs, GetSpanFrom(start));
         }
 
         return lhs;
@@ -479,73 +772,77 @@ namespace scar {
     //      | variable
     //      | function_call
     //      | LIT_INT | LIT_FLOAT | LIT_STRing
-    Ref<ast::Expr> Parser::ExprAtom(unsigned int prec, bool allowEmpty) {
+    ast::Expr* Parser::ExprAtom(unsigned int prec) {
         TextPosition start = m_Token->GetTextPos();
-        Ref<ast::Expr> atom;
+        ast::Expr* atom;
 
         // Parse prefix operator
         if (IsPrefixOperator()) {
-            OperatorInfo opInfo = GetPrefixOperatorInfo(m_Token->Type);
+            const OperatorInfo& opInfo = s_PrefixOperators[m_Token->Type];
             if (opInfo.Precedence >= prec) {
                 Bump();
 
                 // Parse rest of atom
-                atom = Expr(opInfo.Associativity == OperatorInfo::Left ?
-                            opInfo.Precedence + 1 :
-                            opInfo.Precedence);
+                atom = Expr(opInfo.GetRhsPrecedence());
+                if (!atom) {
+                    return nullptr;
+                }
 
-                return MakeRef<ast::PrefixOperator>(ASTPrefixOp(opInfo.TokenType), atom, GetSpanFrom(start));
+                return m_Context.New<ast::PrefixOperator>(ASTPrefixOp(opInfo.TokenType), atom, GetSpanFrom(start));
             }
         }
 
         // Parse atom body
         switch (m_Token->Type) {
         case Token::Ident: {
-            ast::Ident ident = Ident();
+            ast::Ident ident = *Ident();
             if (*m_Token == Token::LParen) {
                 Bump();
-                std::vector<Ref<ast::Expr>> args;
+                std::vector<ast::Expr*> args;
                 while (*m_Token != Token::RParen) {
-                    args.push_back(Expr());
+                    ast::Expr* arg = Expr();
+                    if (!arg) {
+                        return nullptr;
+                    }
+                    args.push_back(arg);
                 }
                 Bump();
-                atom = MakeRef<ast::FunctionCall>(ident, args, GetSpanFrom(start));
+                atom = m_Context.New<ast::FunctionCall>(ident, m_Context.NewList(args), GetSpanFrom(start));
             }
             else {
-                atom = MakeRef<ast::VarAccess>(ident, ident.GetSpan());
+                atom = m_Context.New<ast::VarAccess>(ident, ident.GetSpan());
             }
             break;
         }
         case Token::Var: return VarDecl();
         case Token::True:
-            atom = MakeRef<ast::LiteralBool>(true, GetSpanFrom(start));
+            atom = m_Context.New<ast::LiteralBool>(true, GetSpanFrom(start));
             Bump();
             break;
         case Token::False:
-            atom = MakeRef<ast::LiteralBool>(false, GetSpanFrom(start));
+            atom = m_Context.New<ast::LiteralBool>(false, GetSpanFrom(start));
             Bump();
             break;
         case Token::LitInt:
-            atom = MakeRef<ast::LiteralInteger>(m_Token->GetInt(), ASTType(m_Token->LiteralType), GetSpanFrom(start));
+            atom = m_Context.New<ast::LiteralInteger>(m_Token->GetInt(), ASTType(m_Token->LiteralType), GetSpanFrom(start));
             Bump();
             break;
         case Token::LitFloat:
-            atom = MakeRef<ast::LiteralFloat>(m_Token->GetFloat(), ASTType(m_Token->LiteralType), GetSpanFrom(start));
+            atom = m_Context.New<ast::LiteralFloat>(m_Token->GetFloat(), ASTType(m_Token->LiteralType), GetSpanFrom(start));
             Bump();
             break;
         case Token::LitString:
-            atom = MakeRef<ast::LiteralString>(m_Token->GetName(), GetSpanFrom(start));
+            atom = m_Context.New<ast::LiteralString>(m_Token->GetName(), GetSpanFrom(start));
             Bump();
             break;
         default:
-            if (allowEmpty) { return nullptr; }
-            SPAN_ERROR("invalid expression", GetSpanFrom(start));
-            break;
+            m_Diagnostics.Report(GetSpanFrom(start), DiagID::InvalidExpression);
+            return nullptr;
         }
 
         // Parse suffix operator
         if (IsSuffixOperator()) {
-            OperatorInfo opInfo = GetSuffixOperatorInfo(m_Token->Type);
+            const OperatorInfo& opInfo = s_SuffixOperators[m_Token->Type];
             if (opInfo.Precedence >= prec) {
                 Bump();
                 // Suffix operators also include type casts (x as i32),
@@ -555,54 +852,45 @@ namespace scar {
                 // expression's result type.
                 ast::SuffixOperator::OpType suffixOp = ASTSuffixOp(opInfo.TokenType);
                 if (suffixOp == ast::SuffixOperator::Cast) {
-                    ast::TypeInfo targetType = ASTType(ExpectTypeToken().Type);
-                    return MakeRef<ast::SuffixOperator>(suffixOp, atom, targetType, GetSpanFrom(start));
+                    const Token* typeToken = ExpectTypeToken();
+                    if (!typeToken) {
+                        return nullptr;
+                    }
+                    ast::TypeInfo targetType = ASTType(typeToken->Type);
+                    return m_Context.New<ast::SuffixOperator>(suffixOp, atom, targetType, GetSpanFrom(start));
                 }
 
-                return MakeRef<ast::SuffixOperator>(suffixOp, atom, GetSpanFrom(start));
+                return m_Context.New<ast::SuffixOperator>(suffixOp, atom, GetSpanFrom(start));
             }
         }
 
         return atom;
     }
 
-    Ref<ast::VarDecl> Parser::VarDecl() {
+    ast::VarDecl* Parser::VarDecl() {
         TextPosition start = m_Token->GetTextPos();
 
-        Expect({ Token::Var });
-        ast::Ident ident = Ident();
-        Expect({ Token::Colon });
-        Ref<ast::Type> type = Type();
+        if (!Expect({ Token::Var })) {
+            return nullptr;
+        }
+        std::optional<ast::Ident> ident = Ident();
+        if (!ident || !Expect({ Token::Colon })) {
+            return nullptr;
+        }
+        ast::Type* type = Type();
+        if (!type) {
+            return nullptr;
+        }
 
-        return MakeRef<ast::VarDecl>(ident, type, GetSpanFrom(start));
+        return m_Context.New<ast::VarDecl>(*ident, type, GetSpanFrom(start));
     }
 
-    // prefix_op : + -
-    //           | ! ~
-    //           | ++ --
     bool Parser::IsPrefixOperator() const {
-        return Match({
-            Token::Plus, Token::Minus,
-            Token::Not, Token::BitNot,
-            Token::PlusPlus, Token::MinusMinus });
+        return s_PrefixOperators[m_Token->Type].IsValid();
     }
 
-    // suffix_op : ++ --
     bool Parser::IsSuffixOperator() const {
-        return Match({
-            Token::PlusPlus, Token::MinusMinus, Token::As });
-    }
-
-    // binary_op : + - * / %
-    //           | && || & | ^
-    //           | == != > >= < <=
-    //           | =
-    bool Parser::IsBinaryOperator() const {
-        return Match({
-            Token::Plus, Token::Minus, Token::Star, Token::Slash, Token::Percent,
-            Token::LogicAnd, Token::LogicOr, Token::BitAnd, Token::BitOr, Token::BitXOr,
-            Token::Eq, Token::NotEq, Token::Greater, Token::GreaterEq, Token::Lesser, Token::LesserEq,
-            Token::Assign });
+        return s_SuffixOperators[m_Token->Type].IsValid();
     }
 
 }
\ No newline at end of file
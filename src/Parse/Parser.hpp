@@ -1,60 +1,86 @@
 #pragma once
 #include "Parse/AST/AST.hpp"
+#include "Parse/Lex/TokenSource.hpp"
 #include "Parse/Token.hpp"
 
 namespace scar {
 
-    class Parser {
+    // Errors are reported to the Session's diagnostics and recovered from at the next statement or
+    // declaration. Parse functions return nullptr (or an empty optional) once an error was reported.
+    class Parser : public ast::BodyParser {
     public:
-        explicit Parser(const std::string& path);
+        // Nodes are allocated in the context, which has to outlive the returned Module.
+        // Function bodies are parsed lazily by default, so the Parser has to outlive it too.
+        Parser(const std::string& path, ast::ASTContext& context);
 
-        Ref<ast::Module> Parse();
+        ast::Module* Parse();
+
+        // Number of skipped function bodies that were never asked for
+        uint32_t GetUnparsedBodyCount() const { return m_SkippedBodies - m_ParsedBodies; }
 
     private:
-        TokenStream m_TokenStream;
-        TokenStream::iterator m_Token;
+        ast::ASTContext& m_Context;
+        DiagnosticEngine& m_Diagnostics;
+        TokenSource m_Source;
+        const Token* m_Token;
+        // Parses the bodies this Parser skips
+        ast::BodyParser* m_BodyParser = this;
+        uint32_t m_SkippedBodies = 0;
+        uint32_t m_ParsedBodies = 0;
+        // Tokens of skipped bodies when there's no TokenStream to refer to
+        TokenStream m_SkippedTokens;
+
+        // Parse the Tokens in [begin, end) of an already lexed stream
+        Parser(const TokenStream& tokens, size_t begin, size_t end, ast::ASTContext& context, DiagnosticEngine& diagnostics);
 
         Parser(const Parser&) = delete;
         void operator=(const Parser&) = delete;
 
         void Bump();
         TextSpan GetSpanFrom(const TextPosition& start) const {
-            return TextSpan(m_Token->Span.File, start.Line, start.Col, start.Index, m_Token->Span.Index - start.Index);
+            return TextSpan(m_Token->Span.File, start.Index, m_Token->Span.Index - start.Index);
         }
 
-        bool Match(const std::vector<Token::TokenType>& expected) const;
-        Token& Expect(const std::vector<Token::TokenType>& expected);
-        void Synchronize(const std::vector<Token::TokenType>& delims);
+        bool Match(const TokenSet& expected) const;
+        // Bump past a Token of one of the expected types, nullptr if it's something else
+        const Token* Expect(const TokenSet& expected);
+        void Synchronize(const TokenSet& delims);
+
+        // Parse the top level items in parallel, nullptr if it has to be done sequentially
+        ast::Module* ParseParallel(const TokenStream& tokens);
 
         // Type
-        Ref<ast::Type> Type();
+        ast::Type* Type();
         // Support
-        ast::Ident Ident();
-        ast::Arg Arg();
+        std::optional<ast::Ident> Ident();
+        std::optional<ast::Arg> Arg();
         // Declarations
-        Ref<ast::Stmt> Global();
-        Ref<ast::Stmt> Function();
-        Ref<ast::FunctionPrototype> FunctionPrototype();
-        Ref<ast::VarDecl> VarDecl();
+        ast::Stmt* Global();
+        ast::Stmt* Function();
+        ast::FunctionPrototype* FunctionPrototype();
+        ast::VarDecl* VarDecl();
         // Statements
-        Ref<ast::Stmt> Stmt();
-        Ref<ast::Branch> Branch();
-        Ref<ast::ForLoop> ForLoop();
-        Ref<ast::WhileLoop> WhileLoop();
-        Ref<ast::WhileLoop> Loop();
-        Ref<ast::Block> Block();
-        Ref<ast::Continue> Continue();
-        Ref<ast::Break> Break();
-        Ref<ast::Return> Return();
+        ast::Stmt* Stmt();
+        ast::Branch* Branch();
+        ast::ForLoop* ForLoop();
+        ast::WhileLoop* WhileLoop();
+        ast::WhileLoop* Loop();
+        ast::Block* Block();
+        // Move past a block without parsing it, returns its Tokens
+        std::optional<ast::TokenRange> SkipBlock();
+        ast::Block* ParseBody(ast::TokenRange tokens) override;
+        ast::Continue* Continue();
+        ast::Break* Break();
+        ast::Return* Return();
         // Expressions
-        Ref<ast::Expr> TryExpr();
-        Ref<ast::Expr> Expr(unsigned int prec = 1, bool allowEmpty = false);
-        Ref<ast::Expr> ExprAtom(unsigned int prec, bool allowEmpty = false);
+        // Returns false on errors, expr is nullptr if there's no expression
+        bool TryExpr(ast::Expr*& expr);
+        ast::Expr* Expr(unsigned int prec = 1);
+        ast::Expr* ExprAtom(unsigned int prec);
 
-        Token& ExpectTypeToken();
+        const Token* ExpectTypeToken();
         bool IsPrefixOperator() const;
         bool IsSuffixOperator() const;
-        bool IsBinaryOperator() const;
     };
 
 }
\ No newline at end of file
@@ -3,35 +3,39 @@
 
 namespace scar {
 
+    // Byte offset into a SourceFile
     struct TextPosition {
-        size_t Line, Col;
-        size_t Index;
+        uint32_t Index = 0;
 
-        TextPosition() : Line(1), Col(1), Index(0) {}
-        TextPosition(size_t line, size_t col, size_t index) : Line(line), Col(col), Index(index) {}
+        TextPosition() = default;
+        explicit TextPosition(uint32_t index) : Index(index) {}
     };
 
+    // Line and column aren't stored, they're looked up
+    // from the SourceFile only when a span gets printed
     struct TextSpan {
-        const SourceFile* File;
-        size_t Line = 1, Col = 1;
-        size_t Index = 0, Length = 0;
+        FileID File = 0;
+        uint32_t Index = 0, Length = 0;
 
         TextSpan() = default;
-        TextSpan(const SourceFile* file, size_t line, size_t col, size_t index, size_t length) :
+        TextSpan(FileID file, uint32_t index, uint32_t length) :
             File(file),
-            Line(line), Col(col),
             Index(index), Length(length) {
         }
-        TextSpan(const SourceFile* file, const TextPosition& lo, const TextPosition& hi) :
-            TextSpan(file, lo.Line, lo.Col, lo.Index, hi.Index - lo.Index) {
+        TextSpan(FileID file, const TextPosition& lo, const TextPosition& hi) :
+            TextSpan(file, lo.Index, hi.Index - lo.Index) {
         }
+
+        const SourceFile* GetFile() const { return SourceMap::Get(File); }
     };
 
     static std::string AsString(const TextPosition& pos) {
-        return FMT("{}:{}", pos.Line, pos.Col, pos.Index);
+        return FMT("{}", pos.Index);
     }
     static std::string AsString(const TextSpan& span) {
-        return FMT("{}:{}:{}", span.File->GetFileName(), span.Line, span.Col);
+        const SourceFile* file = span.GetFile();
+        LineCol pos = file->LineColFor(span.Index);
+        return FMT("{}:{}:{}", file->GetFileName(), pos.Line, pos.Col);
     }
 
     static std::ostream& operator<<(std::ostream& os, const TextPosition& pos) {
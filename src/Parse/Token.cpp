@@ -1,5 +1,8 @@
 #include "scarpch.hpp"
 #include "Parse/Token.hpp"
+#include "Core/ThreadPool.hpp"
+
+#include <cstring>
 
 namespace scar {
 
@@ -18,7 +21,11 @@ namespace scar {
     {}
 
     Token::Token(TokenType type, std::string_view val, const TextSpan& span) :
-        Type(type), LiteralType(String), Span(span), m_Value(std::in_place_index_t<2>{}, Interner::Intern(val))
+        Token(type, Interner::Intern(val), span)
+    {}
+
+    Token::Token(TokenType type, Interner::StringID val, const TextSpan& span) :
+        Type(type), LiteralType(String), Span(span), m_Value(std::in_place_index_t<2>{}, val)
     {}
 
     uint64_t Token::GetInt() const {
@@ -36,7 +43,7 @@ namespace scar {
         return std::get<2>(m_Value);
     }
 
-    const std::string& Token::GetString() const {
+    std::string_view Token::GetString() const {
         return Interner::GetString(GetName());
     }
 
@@ -135,4 +142,139 @@ namespace scar {
         return FMT("{}: {}", AsString(token.Span), AsString(token.Type));
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    ///////////////////////////////////////////////////////////////////////////
+    // TOKEN STREAM
+
+    // Tokens whose data word is an index into the literal side table
+    static bool UsesLiteralTable(Token::TokenType type) {
+        return type == Token::LitInt || type == Token::LitFloat || type == Token::LitString || type == Token::Invalid;
+    }
+
+    void TokenStream::push_back(const Token& token) {
+        static_assert(Token::EndOfFile <= UINT8_MAX, "Token types must fit in a byte");
+        SCAR_ASSERT(empty() || token.Span.File == m_File, "all Tokens of a TokenStream must come from the same file!");
+
+        m_File = token.Span.File;
+        m_Types.push_back((uint8_t)token.Type);
+        m_Offsets.push_back(token.Span.Index);
+
+        switch (token.Type) {
+        case Token::Ident:
+            m_Data.push_back(token.GetName());
+            break;
+        case Token::LitInt:
+        case Token::LitFloat:
+        case Token::LitString:
+        case Token::Invalid: {
+            Literal literal;
+            literal.Length = token.Span.Length;
+            literal.LiteralType = token.LiteralType;
+            if (token.Type == Token::LitInt) {
+                literal.Value = token.GetInt();
+            }
+            else if (token.Type == Token::LitFloat) {
+                double value = token.GetFloat();
+                std::memcpy(&literal.Value, &value, sizeof(value));
+            }
+            else if (token.Type == Token::LitString) {
+                literal.Value = token.GetName();
+            }
+            m_Data.push_back((uint32_t)m_Literals.size());
+            m_Literals.push_back(literal);
+            break;
+        }
+        default:
+            m_Data.push_back(token.Span.Length);
+            break;
+        }
+    }
+
+    void TokenStream::reserve(size_t count) {
+        m_Types.reserve(count);
+        m_Offsets.reserve(count);
+        m_Data.reserve(count);
+    }
+
+    TokenStream TokenStream::Join(const std::vector<TokenStream>& parts, ThreadPool& pool) {
+        // Where each part's Tokens and literals go in the joined stream
+        std::vector<size_t> tokenStarts(parts.size() + 1, 0);
+        std::vector<size_t> literalStarts(parts.size() + 1, 0);
+        for (size_t i = 0; i < parts.size(); i++) {
+            bool dropEOF = i + 1 < parts.size() && !parts[i].empty() && parts[i].GetType(parts[i].size() - 1) == Token::EndOfFile;
+            tokenStarts[i + 1] = tokenStarts[i] + parts[i].size() - (dropEOF ? 1 : 0);
+            literalStarts[i + 1] = literalStarts[i] + parts[i].m_Literals.size();
+        }
+
+        TokenStream joined;
+        joined.m_File = parts.empty() ? 0 : parts[0].m_File;
+        joined.m_Types.resize(tokenStarts.back());
+        joined.m_Offsets.resize(tokenStarts.back());
+        joined.m_Data.resize(tokenStarts.back());
+        joined.m_Literals.resize(literalStarts.back());
+
+        pool.ParallelFor(parts.size(), [&](size_t i) {
+            const TokenStream& part = parts[i];
+            SCAR_ASSERT(part.empty() || part.m_File == joined.m_File, "all Tokens of a TokenStream must come from the same file!");
+
+            size_t start = tokenStarts[i];
+            size_t count = tokenStarts[i + 1] - start;
+            uint32_t literalBase = (uint32_t)literalStarts[i];
+
+            std::copy_n(part.m_Types.begin(), count, joined.m_Types.begin() + start);
+            std::copy_n(part.m_Offsets.begin(), count, joined.m_Offsets.begin() + start);
+            std::copy(part.m_Literals.begin(), part.m_Literals.end(), joined.m_Literals.begin() + literalBase);
+
+            // Literal indices were relative to the part's own side table
+            for (size_t j = 0; j < count; j++) {
+                uint32_t data = part.m_Data[j];
+                joined.m_Data[start + j] = UsesLiteralTable(part.GetType(j)) ? data + literalBase : data;
+            }
+        });
+
+        return joined;
+    }
+
+    void TokenStream::RemapNames(const std::vector<Interner::StringID>& names) {
+        for (size_t i = 0; i < size(); i++) {
+            if (GetType(i) == Token::Ident) {
+                m_Data[i] = names[m_Data[i]];
+            }
+        }
+    }
+
+    Token TokenStream::operator[](size_t index) const {
+        Token::TokenType type = GetType(index);
+        uint32_t offset = m_Offsets[index];
+        uint32_t data = m_Data[index];
+
+        switch (type) {
+        case Token::Ident: {
+            uint32_t length = (uint32_t)Interner::GetString(data).length();
+            return Token(type, (Interner::StringID)data, TextSpan(m_File, offset, length));
+        }
+        case Token::LitInt:
+        case Token::LitFloat:
+        case Token::LitString:
+        case Token::Invalid: {
+            const Literal& literal = m_Literals[data];
+            TextSpan span(m_File, offset, literal.Length);
+            if (type == Token::LitInt) {
+                return Token(type, literal.LiteralType, literal.Value, span);
+            }
+            if (type == Token::LitFloat) {
+                double value;
+                std::memcpy(&value, &literal.Value, sizeof(value));
+                return Token(type, literal.LiteralType, value, span);
+            }
+            if (type == Token::LitString) {
+                return Token(type, (Interner::StringID)literal.Value, span);
+            }
+            return Token(span);
+        }
+        default:
+            return Token(type, TextSpan(m_File, offset, data));
+        }
+    }
+
 }
\ No newline at end of file
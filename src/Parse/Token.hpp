@@ -5,6 +5,8 @@
 
 namespace scar {
 
+    class ThreadPool;
+
     class Token {
     public:
         enum TokenType : uint16_t {
@@ -107,19 +109,20 @@ namespace scar {
         Token(TokenType type, TokenType literalType, uint64_t val, const TextSpan& span);
         Token(TokenType type, TokenType literalType, double val, const TextSpan& span);
         Token(TokenType type, std::string_view val, const TextSpan& span);
+        Token(TokenType type, Interner::StringID val, const TextSpan& span);
 
-        TextPosition GetTextPos() const { return TextPosition(Span.Line, Span.Col, Span.Index); }
+        TextPosition GetTextPos() const { return TextPosition(Span.Index); }
         uint64_t GetInt() const;
         double GetFloat() const;
         Interner::StringID GetName() const;
-        const std::string& GetString() const;
+        std::string_view GetString() const;
 
         bool IsEOF() const { return Type == Token::EndOfFile; }
         bool IsValid() const { return Type != Token::Invalid; }
 
         // Get the corresponding source code fragment
         std::string_view GetRaw() const {
-            return Span.File->GetString(Span.Index, Span.Length);
+            return Span.GetFile()->GetString(Span.Index, Span.Length);
         }
 
         bool operator==(const Token::TokenType& type) const { return Type == type; }
@@ -139,24 +142,92 @@ namespace scar {
         return os << AsString(token);
     }
 
-    class TokenStream {
+    // Set of Token types, testing for a type is a single mask check
+    class TokenSet {
     public:
-        using iterator = std::vector<Token>::iterator;
-        using const_iterator = std::vector<Token>::const_iterator;
+        static_assert(Token::EndOfFile < 128, "Token types must fit in a TokenSet");
+
+        constexpr TokenSet() = default;
+        constexpr TokenSet(Token::TokenType type) { Add(type); }
+        constexpr TokenSet(std::initializer_list<Token::TokenType> types) {
+            for (Token::TokenType type : types) {
+                Add(type);
+            }
+        }
+
+        constexpr bool Contains(Token::TokenType type) const {
+            return (m_Bits[type >> 6] >> (type & 63)) & 1;
+        }
+        constexpr bool IsEmpty() const { return (m_Bits[0] | m_Bits[1]) == 0; }
+
+        constexpr TokenSet operator|(const TokenSet& other) const {
+            TokenSet ret;
+            ret.m_Bits[0] = m_Bits[0] | other.m_Bits[0];
+            ret.m_Bits[1] = m_Bits[1] | other.m_Bits[1];
+            return ret;
+        }
+
+    private:
+        uint64_t m_Bits[2] = { 0, 0 };
+
+        constexpr void Add(Token::TokenType type) {
+            m_Bits[type >> 6] |= (uint64_t)1 << (type & 63);
+        }
+    };
+
+    // Prints the types in the set comma separated
+    static std::ostream& operator<<(std::ostream& os, const TokenSet& types) {
+        bool first = true;
+        for (uint16_t type = 0; type <= Token::EndOfFile; type++) {
+            if (types.Contains((Token::TokenType)type)) {
+                os << (first ? "" : ",") << (Token::TokenType)type;
+                first = false;
+            }
+        }
+        return os;
+    }
 
+    // Tokens of a single file stored as parallel arrays.
+    // Every Token takes a type byte, an offset and a data word:
+    //   Ident                      -> StringID, the length is the name's length
+    //   literals and invalid Tokens -> index into the literal side table
+    //   everything else            -> length
+    // Indexing returns a Token rebuilt from those arrays.
+    class TokenStream {
+    public:
         TokenStream() = default;
 
-        void push_back(const Token& token) { m_Tokens.push_back(token); }
+        void push_back(const Token& token);
+        void reserve(size_t count);
 
-        Token& back()             { return m_Tokens.back(); }
-        const Token& back() const { return m_Tokens.back(); }
-        iterator begin()             { return m_Tokens.begin(); }
-        iterator end()               { return m_Tokens.end(); }
-        const_iterator begin() const { return m_Tokens.begin(); }
-        const_iterator end() const   { return m_Tokens.end(); }
+        // Join consecutive streams of the same file into one, copying them on the pool's threads.
+        // Every part except the last one has its EOF dropped.
+        static TokenStream Join(const std::vector<TokenStream>& parts, ThreadPool& pool);
+        // Replace every identifier's name index with names[index]
+        void RemapNames(const std::vector<Interner::StringID>& names);
+
+        Token operator[](size_t index) const;
+        Token back() const { return (*this)[size() - 1]; }
+
+        Token::TokenType GetType(size_t index) const { return (Token::TokenType)m_Types[index]; }
+        // Dense array of every Token's type, for scanning without rebuilding Tokens
+        const uint8_t* GetTypes() const { return m_Types.data(); }
+
+        size_t size() const { return m_Types.size(); }
+        bool empty() const  { return m_Types.empty(); }
 
     private:
-        std::vector<Token> m_Tokens;
+        struct Literal {
+            uint64_t Value = 0; // Integer, bits of a double or StringID
+            uint32_t Length = 0;
+            Token::TokenType LiteralType = Token::Invalid;
+        };
+
+        FileID m_File = 0;
+        std::vector<uint8_t> m_Types;
+        std::vector<uint32_t> m_Offsets;
+        std::vector<uint32_t> m_Data;
+        std::vector<Literal> m_Literals;
     };
 
 }
\ No newline at end of file
@@ -14,3 +14,4 @@
 #include <unordered_set>
 
 #include "Core/Log.hpp"
+#include "Core/Diagnostic.hpp"
@@ -0,0 +1,135 @@
+#include "scarpch.hpp"
+#include "Parse/Interner.hpp"
+
+#include <chrono>
+#include <thread>
+
+// Interns from 1 to N threads at once and checks that every thread gets the same dense StringIDs.
+// Each thread interns every shared string, starting at a different offset so they race on the same
+// strings, and some strings only it interns. Build with -fsanitize=thread to check for data races.
+
+using namespace scar;
+
+static constexpr size_t SharedCount = 100000;
+static constexpr size_t PrivateCount = 20000;
+
+struct ThreadResult {
+    std::vector<Interner::StringID> Shared;
+    std::vector<Interner::StringID> Private;
+    size_t Mismatches = 0;
+};
+
+static std::string SharedString(size_t round, size_t i) {
+    return fmt::format("shared_{}_{}", round, i);
+}
+
+static std::string PrivateString(size_t round, size_t thread, size_t i) {
+    return fmt::format("private_{}_{}_{}", round, thread, i);
+}
+
+static void InternStrings(size_t round, size_t thread, size_t threadCount, ThreadResult& result) {
+    result.Shared.resize(SharedCount);
+    result.Private.resize(PrivateCount);
+
+    size_t start = SharedCount * thread / threadCount;
+    for (size_t n = 0; n < SharedCount; n++) {
+        size_t i = (start + n) % SharedCount;
+        std::string str = SharedString(round, i);
+        Interner::StringID id = Interner::Intern(str);
+        // Reads go through the lock-free page table while other threads keep adding pages
+        result.Mismatches += Interner::GetString(id) != str;
+        result.Shared[i] = id;
+
+        if (n % (SharedCount / PrivateCount) == 0 && n / (SharedCount / PrivateCount) < PrivateCount) {
+            size_t j = n / (SharedCount / PrivateCount);
+            std::string privateStr = PrivateString(round, thread, j);
+            id = Interner::Intern(privateStr);
+            result.Mismatches += Interner::GetString(id) != privateStr;
+            result.Private[j] = id;
+        }
+    }
+}
+
+// Returns false if the StringIDs of the round are wrong
+static bool CheckRound(size_t round, const std::vector<ThreadResult>& results, Interner::StringID first, Interner::StringID end) {
+    size_t threadCount = results.size();
+    size_t expected = SharedCount + PrivateCount * threadCount;
+    if (end - first != expected) {
+        fmt::print("round {}: {} new StringIDs, expected {}\n", round, end - first, expected);
+        return false;
+    }
+
+    // Every ID of the round is handed out exactly once
+    std::vector<bool> seen(expected, false);
+    auto claim = [&](Interner::StringID id) {
+        if (id < first || id >= end || seen[id - first]) {
+            return false;
+        }
+        seen[id - first] = true;
+        return true;
+    };
+
+    for (size_t i = 0; i < SharedCount; i++) {
+        if (!claim(results[0].Shared[i])) {
+            fmt::print("round {}: shared string {} has a duplicate or out of range StringID\n", round, i);
+            return false;
+        }
+        for (const ThreadResult& result : results) {
+            if (result.Shared[i] != results[0].Shared[i]) {
+                fmt::print("round {}: shared string {} got different StringIDs\n", round, i);
+                return false;
+            }
+        }
+        if (Interner::GetString(results[0].Shared[i]) != SharedString(round, i)) {
+            fmt::print("round {}: shared string {} doesn't round-trip\n", round, i);
+            return false;
+        }
+    }
+
+    for (size_t t = 0; t < threadCount; t++) {
+        if (results[t].Mismatches) {
+            fmt::print("round {}: thread {} read back {} wrong strings\n", round, t, results[t].Mismatches);
+            return false;
+        }
+        for (size_t j = 0; j < PrivateCount; j++) {
+            if (!claim(results[t].Private[j]) || Interner::GetString(results[t].Private[j]) != PrivateString(round, t, j)) {
+                fmt::print("round {}: private string {} of thread {} has a wrong StringID\n", round, j, t);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, const char* argv[]) {
+    size_t maxThreads = std::max<size_t>(std::thread::hardware_concurrency(), 4);
+    if (argc > 1) {
+        maxThreads = std::max(std::stoul(argv[1]), 1ul);
+    }
+
+    bool passed = true;
+    size_t round = 0;
+    for (size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2, round++) {
+        std::vector<ThreadResult> results(threadCount);
+        Interner::StringID first = Interner::GetCount();
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; t++) {
+            threads.emplace_back(InternStrings, round, t, threadCount, std::ref(results[t]));
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t calls = (SharedCount + PrivateCount) * threadCount;
+        fmt::print("{} thread{}: {} Intern calls in {:.1f} ms, {:.2f} M/s\n",
+                   threadCount, threadCount > 1 ? "s" : "", calls, seconds * 1000.0, calls / seconds / 1e6);
+
+        passed &= CheckRound(round, results, first, Interner::GetCount());
+    }
+
+    fmt::print("{}\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}